@@ -68,6 +68,24 @@ observer.connection_down = function(e)
   --io.write("\n")
 end
 
+-- This function is called when a stream reaches its depth limit, no more
+-- payload is reported in that direction.
+observer.stream_cutoff = function(e)
+  local a = string.format("Stream cut-off (%s, %d bytes)", e.protocol,
+    e.depth)
+  observer.describe(e, a)
+  io.write("\n")
+end
+
+-- This function is called with a flow summary, when flow records are
+-- enabled.
+observer.flow_record = function(e)
+  local a = string.format("Flow record (%s, %d packets, %d bytes, %s)",
+    e.protocol, e.packets, e.bytes, e.reason)
+  observer.describe(e, a)
+  io.write("\n")
+end
+
 -- This function is called when a datagram is observed, but the protocol
 -- is not recognised.
 observer.unrecognised_datagram = function(e)
@@ -649,7 +667,9 @@ observer.event_handlers = {
   tls_change_cipher_spec = observer.tls_change_cipher_spec,
   tls_handshake_finished = observer.tls_handshake_finished,
   tls_handshake_complete = observer.tls_handshake_complete,
-  tls_application_data = observer.tls_application_data
+  tls_application_data = observer.tls_application_data,
+  stream_cutoff = observer.stream_cutoff,
+  flow_record = observer.flow_record
 }
 
 observer.event = function(e)
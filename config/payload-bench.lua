@@ -0,0 +1,63 @@
+--
+-- Payload access benchmark.  Scans every event payload for newline bytes,
+-- once through the classic fields (e.data, e.body, e.payload), which copy
+-- the payload into a Lua string, and once through the FFI view, which
+-- reads it in place.  Timings are printed every 10000 payloads.  Under
+-- stock Lua only the classic path is timed.
+--
+
+local have_ffi, view = pcall(require, "util.ffi")
+
+local observer = {}
+
+local count = 0
+local classic_time = 0
+local ffi_time = 0
+local classic_lines = 0
+local ffi_lines = 0
+
+local classic = function(e)
+  local p = e.data or e.body or e.payload
+  if p == nil then return false end
+  local n = 0
+  for i = 1, #p do
+    if p:byte(i) == 10 then n = n + 1 end
+  end
+  classic_lines = classic_lines + n
+  return true
+end
+
+local direct = function(e)
+  local v = view.get(e)
+  local n = 0
+  for i = 0, tonumber(v.payload_len) - 1 do
+    if v.payload[i] == 10 then n = n + 1 end
+  end
+  ffi_lines = ffi_lines + n
+end
+
+observer.event = function(e)
+
+  local start = os.clock()
+  if not classic(e) then return end
+  classic_time = classic_time + os.clock() - start
+
+  if have_ffi then
+    start = os.clock()
+    direct(e)
+    ffi_time = ffi_time + os.clock() - start
+  end
+
+  count = count + 1
+  if count % 10000 == 0 then
+    io.write(string.format("payloads=%d classic=%.3fs lines=%d", count,
+                           classic_time, classic_lines))
+    if have_ffi then
+      io.write(string.format(" ffi=%.3fs lines=%d", ffi_time, ffi_lines))
+    end
+    io.write("\n")
+  end
+
+end
+
+return observer
@@ -0,0 +1,40 @@
+--
+-- Zero-copy event access under LuaJIT.  The event's 'view' field is a
+-- pointer to a fixed-layout struct, cast it with the FFI and read the
+-- fields in place:
+--
+--   local view = require("util.ffi")
+--   local v = view.get(e)
+--   for i = 0, tonumber(v.payload_len) - 1 do ... v.payload[i] ... end
+--
+-- The payload pointer is only valid while the event 'e' is referenced.
+-- Needs cybermon built with --with-luajit.
+--
+
+local ffi = require("ffi")
+
+ffi.cdef[[
+typedef struct {
+  int64_t time_sec;
+  int64_t time_usec;
+  const uint8_t* payload;
+  uint64_t payload_len;
+  int32_t action;
+} cybermon_event_view;
+]]
+
+local module = {}
+
+local view_ptr = ffi.typeof("const cybermon_event_view*")
+
+-- Returns the event's view struct.
+module.get = function(e)
+  return ffi.cast(view_ptr, e.view)
+end
+
+-- Copies the payload into a Lua string, for when one is really needed.
+module.payload = function(v)
+  return ffi.string(v.payload, v.payload_len)
+end
+
+return module
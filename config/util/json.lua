@@ -164,6 +164,33 @@ module.connection_down = function(e)
   submit(obs)
 end
 
+-- This function is called when a stream reaches its depth limit
+module.stream_cutoff = function(e)
+  local obs = initialise_observation(e)
+  obs["action"] = "stream_cutoff"
+  obs["stream_cutoff"] = {}
+  obs["stream_cutoff"]["protocol"] = e.protocol
+  obs["stream_cutoff"]["depth"] = e.depth
+  submit(obs)
+end
+
+-- This function is called with a flow summary
+module.flow_record = function(e)
+  local obs = initialise_observation(e)
+  obs["action"] = "flow_record"
+  obs["flow_record"] = {}
+  obs["flow_record"]["protocol"] = e.protocol
+  obs["flow_record"]["packets"] = e.packets
+  obs["flow_record"]["bytes"] = e.bytes
+  obs["flow_record"]["start"] = e.start
+  obs["flow_record"]["end"] = e["end"]
+  obs["flow_record"]["reason"] = e.reason
+  if e.protocol == "tcp" then
+    obs["flow_record"]["tcp_flags"] = e.tcp_flags
+  end
+  submit(obs)
+end
+
 -- This function is called when a datagram is observed, but the protocol
 -- is not recognised.
 module.unrecognised_datagram = function(e)
@@ -752,7 +779,9 @@ module.event_handlers = {
   tls_change_cipher_spec = module.tls_change_cipher_spec,
   tls_handshake_finished = module.tls_handshake_finished,
   tls_handshake_complete = module.tls_handshake_complete,
-  tls_application_data = module.tls_application_data
+  tls_application_data = module.tls_application_data,
+  stream_cutoff = module.stream_cutoff,
+  flow_record = module.flow_record
 }
 
 module.event = function(e)
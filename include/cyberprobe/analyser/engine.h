@@ -22,6 +22,7 @@
 #include <cyberprobe/protocol/manager.h>
 #include <cyberprobe/event/event.h>
 #include <cyberprobe/event/event_implementations.h>
+#include <cyberprobe/util/metrics.h>
 
 namespace cyberprobe {
 
@@ -71,11 +72,50 @@ namespace analyser {
     public:
 
 	// Constructor.
-        engine() { }
+        engine() {
+	    util::metrics::get_registry().get_gauge(
+		"cybermon_contexts",
+		"Protocol contexts currently alive").set_function(
+		    []() -> double {
+			return protocol::base_context::get_total_contexts();
+		    });
+	}
 
 	// Destructor.
 	virtual ~engine() {}
 
+	// Restricts event generation to the listed actions.  Protocol
+	// handlers don't build events which aren't subscribed to.
+	void set_subscriptions(const std::list<event::action_type>& actions) {
+	    static_assert(event::num_actions <= 64,
+			  "Subscription mask is too small");
+	    subscriptions = 0;
+	    for(auto a : actions)
+		subscriptions |= uint64_t(1) << a;
+	}
+
+	// Sets the stream depth for a protocol (e.g. "http", "tls",
+	// "unrecognised", or "default" for all others).  Once a TCP stream
+	// has carried this many payload bytes in one direction, further
+	// payload is counted but not reassembled or processed.  0 means
+	// no limit.
+	void set_stream_depth(const std::string& protocol, uint64_t depth) {
+	    stream_depths[protocol] = depth;
+	}
+
+	// Turns on flow accounting.  TCP, UDP and other IP flows keep
+	// packet and byte counters, and a flow_record event is reported
+	// when the flow expires, and every 'active_timeout' seconds while
+	// it's active.  0 = report on expiry only.
+	void set_flow_records(unsigned long active_timeout) {
+	    flow_accounting = true;
+	    flow_active_timeout = active_timeout;
+	}
+
+	// Reports flow records for all flows still open, e.g. at the end
+	// of input.
+	void flush_flows();
+
 	// Process a packet belong to a device.  'device' describes the
         // context, 's' and 'e' are iterators pointing at the start and end
         // of packet data to process.
@@ -97,12 +137,15 @@ namespace analyser {
 	    context_ptr c = get_root_context(device, network);
 
 	    // Record the known address.
-	    root_context& rc = dynamic_cast<root_context&>(*c);
+	    root_context& rc = static_cast<root_context&>(*c);
 	    rc.set_trigger_address(addr);
 
 	    // This is a reportable event.
-	    auto eptr = std::make_shared<event::trigger_up>(device, addr, tv);
-	    handle(eptr);
+	    if (wants(event::TRIGGER_UP)) {
+		auto eptr = event::create<event::trigger_up>(device, addr,
+							     tv);
+		handle(eptr);
+	    }
 
 	}
 
@@ -114,8 +157,10 @@ namespace analyser {
 	    close_root_context(device, network);
 
 	    // This is a reportable event.
-	    auto eptr = std::make_shared<event::trigger_down>(device, tv);
-	    handle(eptr);
+	    if (wants(event::TRIGGER_DOWN)) {
+		auto eptr = event::create<event::trigger_down>(device, tv);
+		handle(eptr);
+	    }
 
 	}
 
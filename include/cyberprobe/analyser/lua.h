@@ -389,6 +389,38 @@ delete[] buf;
 	    return (lua_isnil(lua, pos) == 1);
 	}
 
+	bool is_table(int pos) {
+	    return (lua_istable(lua, pos) == 1);
+	}
+
+	// Table access without metamethods.
+	void raw_get(int pos) {
+	    lua_rawget(lua, pos);
+	}
+
+	void raw_set(int pos) {
+	    lua_rawset(lua, pos);
+	}
+
+	// Pushes a userdata's user value.  Lua 5.1 has no user values, the
+	// userdata's environment table is used instead.
+	void get_user_value(int pos) {
+#if LUA_VERSION_NUM >= 502
+	    lua_getuservalue(lua, pos);
+#else
+	    lua_getfenv(lua, pos);
+#endif
+	}
+
+	// Pops a table, and sets it as a userdata's user value.
+	void set_user_value(int pos) {
+#if LUA_VERSION_NUM >= 502
+	    lua_setuservalue(lua, pos);
+#else
+	    lua_setfenv(lua, pos);
+#endif
+	}
+
         void new_meta_table(const std::string& name) {
 	    int ret = luaL_newmetatable(lua, name.c_str());
 	    if (ret == 0) {
@@ -417,6 +449,19 @@ delete[] buf;
 
     class lua;
 
+    // Fixed-layout view of an event, for LuaJIT FFI.  A script declares
+    // the same struct with ffi.cdef and casts the event's 'view' field to
+    // a pointer to it, so scalars and the payload are read in place,
+    // without building Lua values.  See config/util/ffi.lua.  The payload
+    // pointer is only valid while the event is referenced.
+    struct event_view {
+	int64_t time_sec;
+	int64_t time_usec;
+	const unsigned char* payload;
+	uint64_t payload_len;
+	int32_t action;
+    };
+
     // We need to pass some values into LUA, so we pass one of these
     // objects as light userdata.  It allows callbacks back into this
     // code to elaborate contexts etc.  This seems the best way to do
@@ -431,6 +476,9 @@ delete[] buf;
 	// Cybermon bridge.
 	lua* cml;
 
+	// Filled in when the 'view' field is first read.
+	event_view view;
+
     };
 
     class context_userdata {
@@ -552,6 +600,11 @@ delete[] buf;
 	// Call the config.event function as event(content, event)
 	void event(analyser::engine& an, std::shared_ptr<event::event> ev);
 
+	// Reads config.subscribe, a list of event action names.  Returns
+	// false if the configuration doesn't declare one, in which case all
+	// events are wanted.
+	bool get_subscriptions(std::list<std::string>& names);
+
 	typedef std::map<std::string,std::pair<std::string,std::string> > 
         http_header;
 
@@ -85,31 +85,44 @@ namespace cyberprobe {
 	    TLS_CHANGE_CIPHER_SPEC,
 	    TLS_HANDSHAKE_FINISHED,
 	    TLS_HANDSHAKE_COMPLETE,
-	    TLS_APPLICATION_DATA
+	    TLS_APPLICATION_DATA,
+	    STREAM_CUTOFF,
+	    FLOW_RECORD
 	};
 
+	// Number of action types.
+	const int num_actions = FLOW_RECORD + 1;
+
 	std::string& action2string(action_type a);
+
+	// Inverse of action2string, throws if the name isn't known.
+	action_type string2action(const std::string& name);
         
 	class event {
 	    static uuid_generator gen;
 	public:
-	    std::string id;
+	    // Event ID, formatted by get_id when asked for.
+	    uuid uid;
 	    action_type action;
 	    timeval time;
-	    event() { id = gen.generate().to_string(); }
+	    event() { uid = gen.generate(); }
 	    event(const action_type action,
 		  const timeval& time) :
-		action(action), time(time)
+		uid(gen.generate()), action(action), time(time)
 		{
-		    id = gen.generate().to_string();
 		}
 	    virtual ~event() {}
+	    std::string get_id() const { return uid.to_string(); }
 	    virtual std::string get_device() const = 0;
 	    virtual std::string& get_action() const {
 		return action2string(action);
 	    }
 	    virtual int get_lua_value(analyser::lua&,
 				      const std::string& name);
+	    // Payload or body bytes, null if the event type has none.
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return 0;
+	    }
 	    virtual void to_json(std::string& doc) {
                 throw std::runtime_error("JSON not implemented.");
 	    }
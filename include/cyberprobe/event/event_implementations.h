@@ -16,6 +16,7 @@
 #include <cyberprobe/protocol/tls_handshake_protocol.h>
 #include <cyberprobe/protocol/ntp_protocol.h>
 #include <cyberprobe/event/event.h>
+#include <cyberprobe/event/event_pool.h>
 #include <cyberprobe/event/event_json.h>
 
 namespace cyberprobe {
@@ -80,6 +81,9 @@ namespace cyberprobe {
 		}
 	    virtual ~unrecognised_stream() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    int64_t position;
 	    virtual void to_json(std::string& doc) {
@@ -136,6 +140,9 @@ namespace cyberprobe {
 		}
 	    virtual ~unrecognised_datagram() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -159,6 +166,9 @@ namespace cyberprobe {
 		}
 	    virtual ~icmp() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    unsigned int type;
 	    unsigned int code;
 	    pdu payload;
@@ -182,6 +192,9 @@ namespace cyberprobe {
 		}
 	    virtual ~imap() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -203,6 +216,9 @@ namespace cyberprobe {
 		}
 	    virtual ~imap_ssl() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -224,6 +240,9 @@ namespace cyberprobe {
 		}
 	    virtual ~pop3() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -245,6 +264,9 @@ namespace cyberprobe {
 		}
 	    virtual ~pop3_ssl() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -266,6 +288,9 @@ namespace cyberprobe {
 		}
 	    virtual ~rtp() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -287,6 +312,9 @@ namespace cyberprobe {
 		}
 	    virtual ~rtp_ssl() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -308,6 +336,9 @@ namespace cyberprobe {
 		}
 	    virtual ~smtp_auth() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -329,6 +360,9 @@ namespace cyberprobe {
 		}
 	    virtual ~sip_ssl() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    pdu payload;
 	    virtual void to_json(std::string& doc) {
 		jsonify(*this, doc);
@@ -353,6 +387,9 @@ namespace cyberprobe {
 		}
 	    virtual ~sip_request() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    const std::string method;
 	    const std::string from;
 	    const std::string to;
@@ -380,6 +417,9 @@ namespace cyberprobe {
 		}
 	    virtual ~sip_response() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    unsigned int code;
 	    const std::string status;
 	    const std::string from;
@@ -407,8 +447,22 @@ namespace cyberprobe {
 		    body.resize(e - s);
 		    std::copy(s, e, body.begin());
 		}
+	    // Takes over the body buffer, rather than copying it.
+	    http_request(const context_ptr cp,
+			 const std::string& method,
+			 const std::string& url,
+			 const http_hdr_t& hdr,
+			 pdu&& body,
+			 const timeval& time) :
+		protocol_event(HTTP_REQUEST, time, cp),
+		method(method), url(url), header(hdr), body(std::move(body))
+		{
+		}
 	    virtual ~http_request() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &body;
+	    }
 	    const std::string method;
 	    const std::string url;
 	    http_hdr_t header;
@@ -435,8 +489,23 @@ namespace cyberprobe {
 		    body.resize(e - s);
 		    std::copy(s, e, body.begin());
 		}
+	    // Takes over the body buffer, rather than copying it.
+	    http_response(const context_ptr cp, unsigned int code,
+			  const std::string& status,
+			  const http_hdr_t& hdr,
+			  const std::string& url,
+			  pdu&& body,
+			  const timeval& time) :
+		protocol_event(HTTP_RESPONSE, time, cp),
+		code(code), status(status), header(hdr), url(url),
+		body(std::move(body))
+		{
+		}
 	    virtual ~http_response() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &body;
+	    }
 	    unsigned int code;
 	    const std::string status;
 	    http_hdr_t header;
@@ -501,8 +570,20 @@ namespace cyberprobe {
 		    body.resize(e - s);
 		    std::copy(s, e, body.begin());
 		}
+	    // Takes over the body buffer, rather than copying it.
+	    smtp_data(const context_ptr cp, const std::string& from,
+		      const std::list<std::string>& to,
+		      pdu&& body,
+		      const timeval& time) :
+		protocol_event(SMTP_DATA, time, cp),
+		from(from), to(to), body(std::move(body))
+		{
+		}
 	    virtual ~smtp_data() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &body;
+	    }
 	    const std::string from;
 	    const std::list<std::string> to;
 	    pdu body;
@@ -654,6 +735,9 @@ namespace cyberprobe {
 		}
 	    virtual ~gre() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    const std::string next_proto;
 	    const uint32_t key;
 	    const uint32_t sequence_no;
@@ -683,6 +767,9 @@ namespace cyberprobe {
 		}
 	    virtual ~gre_pptp() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    const std::string next_proto;
 	    const uint16_t payload_length;
 	    const uint16_t call_id;
@@ -711,6 +798,9 @@ namespace cyberprobe {
 		}
 	    virtual ~esp() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    const uint32_t spi;
 	    const uint32_t sequence;
 	    const uint32_t payload_length;
@@ -738,6 +828,9 @@ namespace cyberprobe {
 		}
 	    virtual ~unrecognised_ip_protocol() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &payload;
+	    }
 	    const uint8_t next_proto;
 	    const uint32_t payload_length;
 	    pdu payload;
@@ -1058,6 +1151,9 @@ namespace cyberprobe {
 		}
 	    virtual ~tls_application_data() {}
 	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    virtual const std::vector<unsigned char>* get_payload() const {
+		return &data;
+	    }
 	    const std::string version;
 	    const std::vector<uint8_t> data;
 	    virtual void to_json(std::string& doc) {
@@ -1068,6 +1164,65 @@ namespace cyberprobe {
 #endif
 	};
 
+	// A stream reached its depth limit, no more payload is processed
+	// in this direction.
+	class stream_cutoff : public protocol_event {
+	public:
+	    stream_cutoff(const context_ptr cp,
+			  const std::string& protocol,
+			  uint64_t depth,
+			  const timeval& time) :
+		protocol_event(STREAM_CUTOFF, time, cp),
+		protocol(protocol), depth(depth)
+		{
+		}
+	    virtual ~stream_cutoff() {}
+	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    const std::string protocol;
+	    const uint64_t depth;
+	    virtual void to_json(std::string& doc) {
+		jsonify(*this, doc);
+	    }
+#ifdef WITH_PROTOBUF
+            virtual void to_protobuf(cyberprobe::Event& ev);
+#endif
+	};
+
+	// Flow summary, reported when a flow expires ("idle") or its active
+	// timeout passes ("active").  Counts cover packets since the
+	// previous record for the flow.
+	class flow_record : public protocol_event {
+	public:
+	    flow_record(const context_ptr cp,
+			const std::string& protocol,
+			uint64_t packets,
+			uint64_t bytes,
+			const timeval& start,
+			const timeval& end,
+			uint8_t tcp_flags,
+			const std::string& reason) :
+		protocol_event(FLOW_RECORD, end, cp),
+		protocol(protocol), packets(packets), bytes(bytes),
+		start(start), end(end), tcp_flags(tcp_flags), reason(reason)
+		{
+		}
+	    virtual ~flow_record() {}
+	    virtual int get_lua_value(analyser::lua&, const std::string& name);
+	    const std::string protocol;
+	    const uint64_t packets;
+	    const uint64_t bytes;
+	    const timeval start;
+	    const timeval end;
+	    const uint8_t tcp_flags;
+	    const std::string reason;
+	    virtual void to_json(std::string& doc) {
+		jsonify(*this, doc);
+	    }
+#ifdef WITH_PROTOBUF
+            virtual void to_protobuf(cyberprobe::Event& ev);
+#endif
+	};
+
     };
 
 };
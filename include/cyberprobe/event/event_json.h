@@ -59,6 +59,8 @@ namespace cyberprobe {
 	class tls_handshake_finished;
 	class tls_handshake_complete;
 	class tls_application_data;
+	class stream_cutoff;
+	class flow_record;
 
 	json jsonify(const connection_up& d);
 	json jsonify(const connection_down& d);
@@ -107,6 +109,8 @@ namespace cyberprobe {
 	json jsonify(const tls_handshake_finished& d);
 	json jsonify(const tls_handshake_complete& d);
 	json jsonify(const tls_application_data& d);
+	json jsonify(const stream_cutoff& d);
+	json jsonify(const flow_record& d);
 	
 
 	template<class C>
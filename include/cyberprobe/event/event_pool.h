@@ -0,0 +1,113 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Event memory pool.  Events are allocated in a burst on the packet
+// thread and freed later by whichever consumer drops the last reference,
+// so each allocating thread has its own pool of size-classed blocks.
+// Blocks freed on the owning thread go straight back on its free list,
+// blocks freed elsewhere are pushed onto a lock-free return list which
+// the owner picks up when its free list runs dry.
+//
+// Use event::create<T>(args...) in place of std::make_shared<T>, the
+// shared_ptr control block and event share one pooled block.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_EVENT_POOL_H
+#define CYBERPROBE_EVENT_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace cyberprobe {
+
+    namespace event {
+
+	class pool {
+	public:
+
+	    // Block sizes are multiples of the granule, larger requests
+	    // aren't pooled.
+	    static const size_t granule = 64;
+	    static const unsigned int classes = 16;
+
+	    // Free blocks kept per size class, beyond this they go back to
+	    // the heap.
+	    static const unsigned int max_cached = 4096;
+
+	    static void* allocate(size_t n);
+	    static void deallocate(void* p);
+
+	private:
+
+	    // Free block, overlays the block's storage.
+	    struct block {
+		block* next;
+	    };
+
+	    // Precedes every block, keeps the storage 16-byte aligned.
+	    struct alignas(16) header {
+		pool* owner;
+		unsigned int cls;
+	    };
+
+	    block* local[classes];
+	    unsigned int cached[classes];
+
+	    // Blocks freed by other threads.
+	    std::atomic<block*> remote[classes];
+
+	    pool();
+
+	    // Pool for the calling thread, created on first use.  Pools are
+	    // never destroyed, blocks may still be returned to them after
+	    // their thread has gone.
+	    static pool& mine();
+
+	    // Moves blocks returned by other threads onto the free list.
+	    void reclaim(unsigned int cls);
+
+	};
+
+	// Standard allocator backed by the pool.
+	template<class T>
+	class allocator {
+	public:
+	    typedef T value_type;
+	    allocator() {}
+	    template<class U> allocator(const allocator<U>&) {}
+	    T* allocate(size_t n) {
+		return static_cast<T*>(pool::allocate(n * sizeof(T)));
+	    }
+	    void deallocate(T* p, size_t) {
+		pool::deallocate(p);
+	    }
+	};
+
+	template<class T, class U>
+	bool operator==(const allocator<T>&, const allocator<U>&) {
+	    return true;
+	}
+
+	template<class T, class U>
+	bool operator!=(const allocator<T>&, const allocator<U>&) {
+	    return false;
+	}
+
+	// Creates a pooled event.
+	template<class T, class... Args>
+	std::shared_ptr<T> create(Args&&... args) {
+	    return std::allocate_shared<T>(allocator<T>(),
+					   std::forward<Args>(args)...);
+	}
+
+    };
+
+};
+
+#endif
+
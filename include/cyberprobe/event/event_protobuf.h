@@ -63,6 +63,8 @@ namespace cyberprobe {
 	class tls_handshake_finished;
 	class tls_handshake_complete;
 	class tls_application_data;
+	class stream_cutoff;
+	class flow_record;
 
         typedef std::string pbuf;
 
@@ -113,6 +115,8 @@ namespace cyberprobe {
         void protobufify(const tls_handshake_finished& d, cyberprobe::Event&);
         void protobufify(const tls_handshake_complete& d, cyberprobe::Event&);
         void protobufify(const tls_application_data& d, cyberprobe::Event&);
+        void protobufify(const stream_cutoff& d, cyberprobe::Event&);
+        void protobufify(const flow_record& d, cyberprobe::Event&);
 
 	template<class C>
 	inline void protobufify(const C& d, pbuf& c) {
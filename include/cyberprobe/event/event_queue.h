@@ -5,9 +5,11 @@
 #include <queue>
 #include <thread>
 #include <condition_variable>
+#include <chrono>
 #include <cstddef>
 
 #include <cyberprobe/event/event.h>
+#include <cyberprobe/util/metrics.h>
 
 namespace cyberprobe {
 
@@ -16,6 +18,10 @@ namespace cyberprobe {
         class observer {
         public:
             virtual void handle(std::shared_ptr<event>) = 0;
+
+            // Called when the queue has been idle for the reader's tick
+            // period.
+            virtual void idle() {}
         };
 
         class basic_queue {
@@ -31,23 +37,35 @@ namespace cyberprobe {
             std::mutex mutex;
             std::condition_variable cond;
 
+            // Queue depth metric.
+            util::metrics::gauge& depth;
+
         public:
 
             void stop() {
                 push(std::shared_ptr<cyberprobe::event::event>(nullptr));
             }
             
-            queue() {}
+            // Consumer names the reader, for the depth metric.
+            queue(const std::string& consumer = "lua") :
+                depth(util::metrics::get_registry().get_gauge(
+                          "cybermon_event_queue_depth",
+                          "Events waiting to be handled",
+                          {{"consumer", consumer}})) {}
             virtual ~queue() {}
 
             virtual void push(eptr e) {
                 std::lock_guard<std::mutex> lock(mutex);
                 q.push(e);
+                depth.inc();
                 cond.notify_one();
             }
 
-            // Reader body.
-            virtual void run(observer& o) {
+            // Reader body.  If tick is non-zero, the observer's idle method
+            // is called when no event has arrived for that period.
+            virtual void run(observer& o,
+                             std::chrono::milliseconds tick =
+                             std::chrono::milliseconds(0)) {
                 
                 std::unique_lock<std::mutex> lock(mutex);
 
@@ -56,12 +74,24 @@ namespace cyberprobe {
 
                     // Have lock at this point.
 
-                    while (q.size() < 1)
-                        cond.wait(lock);
+                    if (tick.count() > 0) {
+                        if (q.size() < 1 &&
+                            !cond.wait_for(lock, tick,
+                                           [this]{ return q.size() > 0; })) {
+                            lock.unlock();
+                            o.idle();
+                            lock.lock();
+                            continue;
+                        }
+                    } else {
+                        while (q.size() < 1)
+                            cond.wait(lock);
+                    }
                     
                     // Take next packet off queue.
                     eptr e = q.front();
                     q.pop();
+                    depth.dec();
 
                     // Null pointer indicates end of stream.
                     if (!e) {
@@ -0,0 +1,141 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// JSON-lines event writer.  Serialises events straight from an event queue
+// to a file, one JSON object per line, on a dedicated writer thread.  The
+// file can be rotated on size or age, and optionally compressed.  This
+// does the same job as the json.lua configuration without the Lua
+// overhead.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_EVENT_JSONL_WRITER_H
+#define CYBERPROBE_EVENT_JSONL_WRITER_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string>
+#include <memory>
+#include <thread>
+
+#include <cyberprobe/event/event.h>
+#include <cyberprobe/event/event_queue.h>
+#include <cyberprobe/util/metrics.h>
+
+namespace cyberprobe {
+
+    namespace event {
+
+	// Output file, possibly compressed.  Defined in the implementation.
+	class jsonl_file;
+
+	class jsonl_writer : public observer {
+	public:
+
+	    enum compression { NONE, GZIP, ZSTD };
+
+	    // Output settings.
+	    class spec {
+	    public:
+
+		// Output filename.  Rotated files have a timestamp inserted
+		// before the extension, e.g. events.jsonl becomes
+		// events-20190101T000000Z.jsonl.
+		std::string path;
+
+		// Rotate after this many bytes (before compression), 0 = no
+		// size limit.
+		uint64_t rotate_size;
+
+		// Rotate after this many seconds, 0 = no time limit.
+		unsigned int rotate_time;
+
+		// Compression.
+		compression compress;
+
+		spec() : rotate_size(0), rotate_time(0), compress(NONE) {}
+
+		// Parses an output description of the form
+		// PATH[,rotate-size=N[k|M|G]][,rotate-time=SECS]
+		// [,compress=gzip|zstd].  Throws on error.
+		static spec parse(const std::string& desc);
+
+	    };
+
+	private:
+
+	    spec sp;
+
+	    // Events for this writer.
+	    queue q;
+
+	    std::thread* thr;
+
+	    // Current output file.
+	    std::unique_ptr<jsonl_file> file;
+
+	    // Write buffer, flushed when full or idle.
+	    std::string buffer;
+
+	    // Re-used per-event JSON document.
+	    std::string doc;
+
+	    // Bytes written to the current file, and when it was opened.
+	    uint64_t written;
+	    time_t opened;
+
+	    // Metrics.
+	    util::metrics::counter& events;
+	    util::metrics::counter& bytes;
+	    util::metrics::counter& rotations;
+
+	    void open();
+	    void close();
+	    void flush();
+	    void rotate();
+
+	    // Rotates if the current file is too old.
+	    void check_age();
+
+	public:
+
+	    // Buffer is flushed at this size.
+	    static const unsigned int buffer_size = 256 * 1024;
+
+	    jsonl_writer(const spec& sp);
+	    virtual ~jsonl_writer();
+
+	    // The writer's queue, events should be pushed here.
+	    basic_queue& get_queue() { return q; }
+
+	    // Observer interface, called on the writer thread.
+	    virtual void handle(std::shared_ptr<event> e);
+	    virtual void idle();
+
+	    // Thread body.
+	    virtual void run();
+
+	    virtual void start() {
+		thr = new std::thread(&jsonl_writer::run, this);
+	    }
+
+	    // Queues end-of-stream, the writer exits once the queue is
+	    // drained.
+	    virtual void stop() {
+		q.stop();
+	    }
+
+	    virtual void join() {
+		if (thr) thr->join();
+	    }
+
+	};
+
+    };
+
+};
+
+#endif
+
@@ -18,6 +18,8 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <time.h>
+#include <sys/uio.h>
 
 #include <memory>
 
@@ -372,6 +374,54 @@ namespace tcpip {
     };
 
     /** A UDP socket. */
+    class udp_socket;
+
+    /** A batch of datagram buffers, filled by udp_socket::read_batch.
+	Buffers are allocated once and re-used on every read, so receiving
+	doesn't allocate. */
+    class datagram_batch {
+    private:
+	friend class udp_socket;
+
+	unsigned int count;
+	unsigned int size;
+
+	std::vector<unsigned char> bufs;
+	std::vector<struct mmsghdr> msgs;
+	std::vector<struct iovec> iovs;
+	std::vector<char> ctrl;
+	std::vector<unsigned int> lens;
+	std::vector<struct timespec> times;
+
+	// Control message space per datagram.
+	static size_t ctrl_size() {
+	    return CMSG_SPACE(sizeof(struct timespec));
+	}
+
+    public:
+
+	/** Number of datagrams filled by the last read. */
+	unsigned int filled;
+
+	/** 'count' buffers of 'size' bytes each. */
+	datagram_batch(unsigned int count = 64, unsigned int size = 65536);
+
+	/** Maximum datagrams per read. */
+	unsigned int capacity() const { return count; }
+
+	/** Data of datagram i. */
+	const unsigned char* data(unsigned int i) const {
+	    return &bufs[i * size];
+	}
+
+	/** Length of datagram i. */
+	unsigned int length(unsigned int i) const { return lens[i]; }
+
+	/** Receive time of datagram i, kernel timestamp if available. */
+	const struct timespec& time(unsigned int i) const { return times[i]; }
+
+    };
+
     class udp_socket : public socket {
     public:
 	int sock;
@@ -398,6 +448,17 @@ namespace tcpip {
 	/** Read from the socket. With buffering. */
 	virtual int read(std::vector<unsigned char>& buffer, int len);
 
+	/** Read as many datagrams as are waiting, up to the batch capacity,
+	    without blocking.  Returns the number read, which may be 0. */
+	virtual int read_batch(datagram_batch& batch);
+
+	/** Allow several sockets to bind the same port, the kernel spreads
+	    datagrams across them.  Call before bind. */
+	virtual void set_reuseport();
+
+	/** Ask the kernel to timestamp received datagrams. */
+	virtual void set_timestamps();
+
 	/** Write to the socket. */
 	virtual int write(const char* buffer, int len) {
 	    return ::write(sock, buffer, len);
@@ -14,6 +14,20 @@
 #include <iostream>
 #include <string.h>
 #include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <map>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 
 extern "C" {
 #include <pcap.h>
@@ -41,10 +55,12 @@ protected:
 
 private:
 
-    // Packet filter state.
-    struct bpf_program fltr;
     packet_handler& handler;
 
+    // A filter compiled by replace_filter, waiting for the capture thread
+    // to install it.
+    std::atomic<struct bpf_program*> pending_filter;
+
 protected:
 
     // Internal PCAP call-back.
@@ -60,18 +76,28 @@ protected:
 public:
 
     // Constructor.
-    capture(packet_handler& h) : handler(h) {
+    capture(packet_handler& h) : handler(h), pending_filter(0) {
         p = 0; running = true;
     }
 
     // Destructor.
-    virtual ~capture() { if (p) pcap_close(p); p = 0; }
+    virtual ~capture() {
+        if (p) pcap_close(p);
+        p = 0;
+        struct bpf_program* f = pending_filter.exchange(0);
+        if (f) {
+            pcap_freecode(f);
+            delete f;
+        }
+    }
 
     // Adds a filter to the capture class.  spec specifies a PCAP-style
     // filter statement.  See 'pcap' man-page.  Throws a runtime_error
     // exception if compilation fails.
     void add_filter(const std::string& spec) {
 
+        struct bpf_program fltr;
+
 	// Zero out the compilation filter.
         memset((void*) &fltr, 0, sizeof(fltr));
 
@@ -80,13 +106,67 @@ public:
 	if (ret < 0)
 	    throw std::runtime_error(pcap_geterr(p));
 
-	// Attach to PCAP handle.
+	// Attach to PCAP handle, which takes a copy.
 	ret = pcap_setfilter(p, &fltr);
+        pcap_freecode(&fltr);
 	if (ret < 0)
 	    throw std::runtime_error(pcap_geterr(p));
 
     }
 
+    // Replaces the filter on a running capture, from another thread.  The
+    // filter is compiled here, so errors are thrown to the caller, and
+    // installed by the capture thread between packets.  The kernel swaps
+    // the filter in one step, so no packets are missed.
+    void replace_filter(const std::string& spec) {
+
+        pcap_t* d = pcap_open_dead(pcap_datalink(p), pcap_snapshot(p));
+        if (d == 0)
+            throw std::runtime_error("pcap_open_dead failed.");
+
+        struct bpf_program* f = new bpf_program;
+        memset((void*) f, 0, sizeof(*f));
+
+        int ret = pcap_compile(d, f, (char*) spec.c_str(), 1, 0);
+        if (ret < 0) {
+            std::string err = pcap_geterr(d);
+            pcap_close(d);
+            delete f;
+            throw std::runtime_error("Filter expression failed: " + err);
+        }
+
+        pcap_close(d);
+
+        // Replaces any filter not yet installed.
+        f = pending_filter.exchange(f);
+        if (f) {
+            pcap_freecode(f);
+            delete f;
+        }
+
+    }
+
+protected:
+
+    // Called by the capture thread to install a replaced filter.
+    void install_pending_filter() {
+
+        if (pending_filter.load(std::memory_order_relaxed) == 0) return;
+
+        struct bpf_program* f = pending_filter.exchange(0);
+        if (f == 0) return;
+
+        if (pcap_setfilter(p, f) < 0)
+            std::cerr << "Filter replacement failed: " << pcap_geterr(p)
+                      << std::endl;
+
+        pcap_freecode(f);
+        delete f;
+
+    }
+
+public:
+
     // Invokes packet processing on this capture handle, channelling received
     // packets through the 'handle' method.  Keeps processing forever or
     // until the 'stop' method is called.
@@ -98,6 +178,8 @@ public:
 
         while (running) {
 
+            install_pending_filter();
+
             int ret = ::poll(&pfd, 1, 500);
             if (ret < 0)
                 throw std::runtime_error("Poll failed");
@@ -159,6 +241,19 @@ public:
 #ifdef HAVE_PCAP_SET_TIMEOUT
             pcap_set_timeout(p, 1);
 #endif
+
+#ifdef HAVE_PCAP_SET_TSTAMP_TYPE
+            // Use the adapter's timestamps if it has them.  Only ones
+            // synchronised with the system clock, delay lines compare
+            // capture times with the time now.
+            int* types = 0;
+            int ntypes = pcap_list_tstamp_types(p, &types);
+            for(int i = 0; i < ntypes; i++)
+                if (types[i] == PCAP_TSTAMP_ADAPTER)
+                    pcap_set_tstamp_type(p, PCAP_TSTAMP_ADAPTER);
+            if (types)
+                pcap_free_tstamp_types(types);
+#endif
             
             int ret = pcap_activate(p);
             if (ret < 0) {
@@ -210,33 +305,368 @@ public:
 	    throw std::runtime_error("pcap_dump_open_dead failed.");
     }
 
-    void write(std::vector<unsigned char>::const_iterator begin,
+    // Writes a packet with its capture time.
+    void write(const timeval& tv,
+	       std::vector<unsigned char>::const_iterator begin,
 	       std::vector<unsigned char>::const_iterator end) {
 
 	struct pcap_pkthdr h;
-
-	// Get time
-	gettimeofday(&h.ts, 0);
+	h.ts = tv;
 
 	// Set packet lengths in header
 	h.caplen = end - begin;
 	h.len = end - begin;
 
-	unsigned char buf[end - begin];
-	std::copy(begin, end, buf);
-
-	// Output in PCAP.
-	pcap_dump((unsigned char *) dumper, &h, buf);
+	// Output in PCAP, straight from the vector.
+	pcap_dump((unsigned char *) dumper, &h,
+		  begin == end ? 0 : &*begin);
 
     }
     void close() {
 	if (p == 0) return;
 	pcap_dump_close(dumper);
 	pcap_close(p);
+	p = 0;
     }
     ~writer() { close(); }
 };
 
+// Writes a PCAP file per stream, e.g. per LIID, rotated on size and age.
+// Packets are appended to the stream's buffer under the stream's own lock,
+// and full buffers are written by a background thread, so callers
+// writing different streams don't wait on each other or on the disk.
+// Buffered data is written out at least once a second, and files which
+// have gone quiet are still closed on time.
+class rolling_writer {
+public:
+
+    typedef std::vector<unsigned char>::const_iterator const_iterator;
+
+    // Data goes to disk in blocks of this size.
+    static const size_t buffer_size = 1024 * 1024;
+
+    // Blocks waiting to be written, beyond which writers wait.
+    static const size_t max_pending = 64;
+
+    // Files are written to 'dir', called NAME-YYYYMMDD-HHMMSS-N.pcap.  A
+    // file is closed, and another started, once it reaches 'max_bytes',
+    // or 'max_secs' after its first packet.  0 means no limit.
+    rolling_writer(const std::string& dir, uint64_t max_bytes = 0,
+		   unsigned int max_secs = 0) :
+	dir(dir), max_bytes(max_bytes), max_secs(max_secs), running(true) {
+	thr = new std::thread(&rolling_writer::run, this);
+    }
+
+    ~rolling_writer() { close(); }
+
+    // Writes a packet to the named stream's file.
+    void write(const std::string& name, const timeval& tv,
+	       const_iterator begin, const_iterator end) {
+
+	stream& st = get_stream(name);
+
+	std::unique_lock<std::mutex> lock(st.mutex);
+
+	uint32_t len = end - begin;
+
+	// Hand off what's due.  If the writer thread is behind, wait for it
+	// with the stream unlocked, and look again.
+	while (true) {
+
+	    if (st.fd >= 0) {
+		bool full = max_bytes && st.bytes + 16 + len > max_bytes;
+		bool old = max_secs &&
+		    tv.tv_sec - st.opened >= (time_t) max_secs;
+		if ((full || old) && !hand_off(st, true)) {
+		    wait_for_writer(lock);
+		    continue;
+		}
+	    }
+
+	    if (st.fd < 0)
+		open(st, name, tv);
+
+	    if (st.buf->size() + 16 + len > buffer_size && !st.buf->empty() &&
+		!hand_off(st, false)) {
+		wait_for_writer(lock);
+		continue;
+	    }
+
+	    break;
+
+	}
+
+	// Record header, native byte order as is the file header.
+	uint32_t hdr[4];
+	hdr[0] = tv.tv_sec;
+	hdr[1] = tv.tv_usec;
+	hdr[2] = len;
+	hdr[3] = len;
+	const unsigned char* h = reinterpret_cast<const unsigned char*>(hdr);
+	st.buf->insert(st.buf->end(), h, h + sizeof(hdr));
+	st.buf->insert(st.buf->end(), begin, end);
+	st.bytes += sizeof(hdr) + len;
+
+    }
+
+    // Writes out everything buffered, closes the files and stops the
+    // background thread.
+    void close() {
+
+	if (thr == 0) return;
+
+	// Streams are never removed, so they can be worked through without
+	// holding streams_mutex, which the writer thread needs.
+	std::vector<stream*> all;
+	{
+	    std::lock_guard<std::mutex> lock(streams_mutex);
+	    for(auto& it : streams)
+		all.push_back(it.second.get());
+	}
+
+	for(auto st : all) {
+	    std::unique_lock<std::mutex> sl(st->mutex);
+	    while (st->fd >= 0 && !hand_off(*st, true))
+		wait_for_writer(sl);
+	}
+
+	{
+	    std::lock_guard<std::mutex> lock(jobs_mutex);
+	    running = false;
+	    jobs_cond.notify_all();
+	}
+
+	thr->join();
+	delete thr;
+	thr = 0;
+
+    }
+
+private:
+
+    typedef std::vector<unsigned char> buffer;
+    typedef std::unique_ptr<buffer> buffer_ptr;
+
+    // An open file, and packets not yet handed to the writer thread.
+    class stream {
+    public:
+	std::mutex mutex;
+	int fd;
+	uint64_t bytes;
+	time_t opened;
+	std::chrono::steady_clock::time_point opened_at;
+	unsigned int seq;
+	buffer_ptr buf;
+	stream() : fd(-1), bytes(0), opened(0), seq(0) {}
+    };
+
+    // A block to write, closing the file afterwards if 'last'.
+    class job {
+    public:
+	int fd;
+	buffer_ptr buf;
+	bool last;
+    };
+
+    std::string dir;
+    uint64_t max_bytes;
+    unsigned int max_secs;
+
+    // Only held to find a stream.
+    std::mutex streams_mutex;
+    std::map<std::string, std::unique_ptr<stream> > streams;
+
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_cond;
+    std::deque<job> jobs;
+    std::vector<buffer_ptr> spare;
+    bool running;
+    std::thread* thr;
+
+    stream& get_stream(const std::string& name) {
+	std::lock_guard<std::mutex> lock(streams_mutex);
+	std::unique_ptr<stream>& st = streams[name];
+	if (!st) st.reset(new stream());
+	return *st;
+    }
+
+    // Opens the next file, and starts its buffer with the file header.
+    // Called with the stream locked.
+    void open(stream& st, const std::string& name, const timeval& tv) {
+
+	// Keep the name to one path component.
+	std::string n = name;
+	for(auto& c : n)
+	    if (c == '/') c = '_';
+
+	char when[32];
+	struct tm t;
+	time_t secs = tv.tv_sec;
+	gmtime_r(&secs, &t);
+	strftime(when, sizeof(when), "%Y%m%d-%H%M%S", &t);
+
+	std::string path = dir + "/" + n + "-" + when + "-" +
+	    std::to_string(st.seq++) + ".pcap";
+
+	int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	    throw std::runtime_error("Couldn't create " + path);
+
+	st.fd = fd;
+	st.opened = tv.tv_sec;
+	st.opened_at = std::chrono::steady_clock::now();
+	if (!st.buf) st.buf = get_buffer();
+
+	// File header: magic, version 2.4, zone, accuracy, snaplen,
+	// LINKTYPE_RAW.
+	uint32_t hdr[6];
+	hdr[0] = 0xa1b2c3d4;
+	hdr[1] = 2 | (4 << 16);
+	hdr[2] = 0;
+	hdr[3] = 0;
+	hdr[4] = 65535;
+	hdr[5] = 101;
+	const unsigned char* h = reinterpret_cast<const unsigned char*>(hdr);
+	st.buf->insert(st.buf->end(), h, h + sizeof(hdr));
+	st.bytes = sizeof(hdr);
+
+    }
+
+    // Passes the stream's buffer to the writer thread, closing the file
+    // if 'last'.  Returns false if the writer is behind, see
+    // wait_for_writer.  Called with the stream locked.
+    bool hand_off(stream& st, bool last) {
+
+	std::lock_guard<std::mutex> lock(jobs_mutex);
+
+	if (running && jobs.size() >= max_pending)
+	    return false;
+
+	job j;
+	j.fd = st.fd;
+	j.buf = std::move(st.buf);
+	j.last = last;
+	jobs.push_back(std::move(j));
+	jobs_cond.notify_all();
+
+	st.buf = take_spare();
+	if (last) st.fd = -1;
+
+	return true;
+
+    }
+
+    // Waits for the writer thread to catch up.  The stream is unlocked
+    // meanwhile, as the writer thread may want it, so the caller must
+    // look at the stream again afterwards.
+    void wait_for_writer(std::unique_lock<std::mutex>& sl) {
+	sl.unlock();
+	{
+	    std::unique_lock<std::mutex> lock(jobs_mutex);
+	    while (running && jobs.size() >= max_pending)
+		jobs_cond.wait(lock);
+	}
+	sl.lock();
+    }
+
+    // A buffer, reusing one already written if there is one.  Called
+    // with jobs_mutex held.
+    buffer_ptr take_spare() {
+	if (spare.empty()) return get_buffer();
+	buffer_ptr b = std::move(spare.back());
+	spare.pop_back();
+	return b;
+    }
+
+    static buffer_ptr get_buffer() {
+	buffer_ptr b(new buffer());
+	b->reserve(buffer_size);
+	return b;
+    }
+
+    // Writes a buffer to the file in full.
+    static void write_all(int fd, const buffer& b) {
+	size_t pos = 0;
+	while (pos < b.size()) {
+	    ssize_t ret = ::write(fd, b.data() + pos, b.size() - pos);
+	    if (ret < 0 && errno == EINTR) continue;
+	    if (ret <= 0) {
+		std::cerr << "PCAP write failed: " << strerror(errno)
+			  << std::endl;
+		return;
+	    }
+	    pos += ret;
+	}
+    }
+
+    // Hands off the buffers of streams which haven't filled a buffer
+    // lately, so nothing sits in memory for long, and closes files which
+    // have been open 'max_secs', as a quiet stream has no packet to
+    // close it.  A stream which is locked is busy, so it's skipped rather
+    // than waited for.
+    void flush_idle() {
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(streams_mutex);
+	for(auto& it : streams) {
+	    stream& st = *it.second;
+	    std::unique_lock<std::mutex> sl(st.mutex, std::try_to_lock);
+	    if (!sl.owns_lock() || st.fd < 0) continue;
+	    bool old = max_secs &&
+		now - st.opened_at >= std::chrono::seconds(max_secs);
+	    if (old || (st.buf && !st.buf->empty()))
+		if (!hand_off(st, old))
+		    return;
+	}
+    }
+
+    // Writer thread body.
+    void run() {
+
+	std::unique_lock<std::mutex> lock(jobs_mutex);
+
+	// Busy streams keep the writer from ever waiting a whole second,
+	// so the idle pass goes by the clock.
+	auto next_flush =
+	    std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+	while (true) {
+
+	    if (jobs.empty() && !running) break;
+
+	    if (std::chrono::steady_clock::now() >= next_flush) {
+		lock.unlock();
+		flush_idle();
+		lock.lock();
+		next_flush =
+		    std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		continue;
+	    }
+
+	    if (jobs.empty()) {
+		jobs_cond.wait_until(lock, next_flush);
+		continue;
+	    }
+
+	    job j = std::move(jobs.front());
+	    jobs.pop_front();
+	    jobs_cond.notify_all();
+
+	    lock.unlock();
+
+	    write_all(j.fd, *j.buf);
+	    if (j.last) ::close(j.fd);
+	    j.buf->clear();
+
+	    lock.lock();
+
+	    spare.push_back(std::move(j.buf));
+
+	}
+
+    }
+
+};
+
 };
 
 };
@@ -10,9 +10,12 @@
 
 #include <cyberprobe/pkt_capture/packet_capture.h>
 #include <cyberprobe/probe/packet_consumer.h>
+#include <cyberprobe/util/metrics.h>
 
-#include <queue>
+#include <vector>
 #include <thread>
+#include <atomic>
+#include <stdint.h>
 
 namespace cyberprobe {
 
@@ -25,21 +28,34 @@ public:
     virtual void start() = 0;
     virtual void join() = 0;
 
+    // Changes the filter and delay of a running device, without stopping
+    // the capture.  Returns false if the device can't do that, and so has
+    // to be restarted.
+    virtual bool reconfigure(const std::string& filter, float delay) {
+        return false;
+    }
+
 };
 
 using packet_handler = cyberprobe::pcap::packet_handler;
 
 class delayline : public device {
+public:
+
+    // What to do with a packet which doesn't fit in the delay buffer.
+    enum overflow_policy {
+	DROP,			// Discard the arriving packet.
+	SPILL			// Release the oldest packets early.
+    };
+
+    // Default delay buffer size, bytes.
+    static const uint64_t default_buffer = 64 * 1024 * 1024;
+
 protected:
 
     // Handle to the deliver engine.
     packet_consumer& deliv;
 
-    struct delayed_packet {
-	std::vector<unsigned char> packet;
-	struct timeval exit_time;
-    };
-
     // Seconds of delay
     float delay;
 
@@ -47,49 +63,79 @@ protected:
     // on the IP packet.
     int datalink;
 
-    // Delay converted to timeval form.
-    struct timeval delay_val;
+    // Delay in microseconds.
+    uint64_t delay_usec;
 
-    std::queue<delayed_packet> delay_line;
+    // A delay set by set_delay, waiting for the capture thread to apply it.
+    std::atomic<bool> delay_changed;
+    std::atomic<uint64_t> pending_delay_usec;
 
-public:
+    // Delay buffer size, the ring is only allocated once there's a delay.
+    uint64_t buffer_size;
 
-    delayline(packet_consumer& deliv, float delay, int datalink) :
-        deliv(deliv), delay(delay), datalink(datalink) {
+    // The delay line is a byte ring, allocated up-front.  Each packet is
+    // stored as a 12-byte header (8-byte capture time in microseconds,
+    // 4-byte length) followed by the packet data.  Records may wrap
+    // around the end of the ring.  'head' and 'tail' are byte offsets
+    // which only ever increase, the ring position is the offset modulo
+    // the ring size.
+    static const unsigned int header_size = 12;
+    std::vector<unsigned char> ring;
+    uint64_t head;
+    uint64_t tail;
 
-        // Calculate delay in form of a timeval.
-        uint64_t delay_usec = delay * 1000000;
-        delay_val.tv_usec = delay_usec % 1000000;
-        delay_val.tv_sec = delay_usec / 1000000;
+    overflow_policy overflow;
 
-    }
+    // Scratch space used to hand packets to the delivery engine, re-used
+    // to avoid an allocation per packet.
+    std::vector<unsigned char> out;
 
-    virtual ~delayline() {}
-        
-    // Packet handler.
-    virtual void handle(timeval tv, unsigned long len,
-			const unsigned char* bytes);
+    // Metrics.
+    util::metrics::counter& dropped;
+    util::metrics::counter& spilled;
+    util::metrics::gauge& buffered;
 
-    virtual void service_delayline() {
+    // Identifies this capture to the consumer.
+    packet_source source;
 
-	struct timeval now;
-	gettimeofday(&now, 0);
+    // Copy in/out of the ring, handling wrap-around.
+    void ring_write(uint64_t pos, const unsigned char* data, uint64_t len);
+    void ring_read(uint64_t pos, unsigned char* data, uint64_t len);
 
-	while (!(delay_line.empty())) {
+    // Read the header of the packet at the head of the ring.
+    void read_header(uint64_t& time, uint32_t& len);
 
-	    if (delay_line.front().exit_time.tv_sec > now.tv_sec) break;
+    // Deliver the packet at the head of the ring, with its capture time.
+    void release();
 
-	    if ((delay_line.front().exit_time.tv_sec == now.tv_sec) &&
-		(delay_line.front().exit_time.tv_usec > now.tv_usec))
-		break;
+    // Time now, microseconds.  Uses the coarse clock, the delay line
+    // doesn't need better than a few milliseconds accuracy.
+    static uint64_t now_usec();
 
-	    // Packet ready to go.
-	    deliv.receive_packet(now, delay_line.front().packet, datalink);
-	    delay_line.pop();
+    // Applies a delay set by set_delay.  Called in the capture thread.
+    void apply_delay();
 
-	}
+public:
 
-    }
+    // Constructor.  'name' labels the metrics, 'buffer' is the size of the
+    // delay buffer in bytes.
+    delayline(packet_consumer& deliv, float delay, int datalink,
+	      const std::string& name,
+	      uint64_t buffer = default_buffer,
+	      overflow_policy overflow = SPILL);
+
+    virtual ~delayline() {}
+        
+    // Packet handler.
+    virtual void handle(timeval tv, unsigned long len,
+			const unsigned char* bytes);
+
+    // Deliver packets whose delay has expired.
+    virtual void service_delayline();
+
+    // Changes the delay, from another thread.  Packets already in the
+    // delay line are released in order, none are lost.
+    void set_delay(float delay);
 
 };
 
@@ -100,10 +146,34 @@ private:
     pcap_t* p;
     bool filtering;
 
+    // A filter compiled by replace_filter, waiting for the capture thread
+    // to install it.
+    std::atomic<struct bpf_program*> pending;
+
+    // Installs a replaced filter.  Called in the capture thread.
+    void install_filter() {
+
+        struct bpf_program* f = pending.exchange(0);
+        if (f == 0) return;
+
+        if (filtering)
+            pcap_freecode(&fltr);
+
+        fltr = *f;
+        delete f;
+
+        filtering = true;
+
+    }
+
 public:
 
-    filtering_device(packet_consumer& deliv, float delay, int datalink) :
-        delayline(deliv, delay, datalink) {
+    filtering_device(packet_consumer& deliv, float delay, int datalink,
+		     const std::string& name,
+		     uint64_t buffer = default_buffer,
+		     overflow_policy overflow = SPILL) :
+        delayline(deliv, delay, datalink, name, buffer, overflow),
+        pending(0) {
 
         // Only used for filtering.
         p = pcap_open_dead(datalink, 65535);
@@ -122,6 +192,12 @@ public:
             pcap_freecode(&fltr);
         }
 
+        struct bpf_program* f = pending.exchange(0);
+        if (f) {
+            pcap_freecode(f);
+            delete f;
+        }
+
         if (p) pcap_close(p);
 
     }
@@ -144,6 +220,35 @@ public:
 
     }
 
+    // Replaces the filter on a running device, from another thread.  The
+    // filter is compiled here, so errors are thrown to the caller, and
+    // installed by the capture thread before the next packet.
+    void replace_filter(const std::string& spec) {
+
+        struct bpf_program* f = new bpf_program;
+        memset((void*) f, 0, sizeof(*f));
+
+	int ret = pcap_compile(p, f, (char*) spec.c_str(), 1, 0);
+	if (ret < 0) {
+            delete f;
+	    throw std::runtime_error(std::string("Filter expression failed: ") +
+                                     pcap_geterr(p));
+        }
+
+        f = pending.exchange(f);
+        if (f) {
+            pcap_freecode(f);
+            delete f;
+        }
+
+    }
+
+    virtual bool reconfigure(const std::string& filter, float delay) {
+        replace_filter(filter);
+        set_delay(delay);
+        return true;
+    }
+
     template<class C>
     bool apply_filter(C s, C e) {
 
@@ -152,6 +257,9 @@ public:
         hdr.caplen = e - s;
         hdr.len = e - s;
 
+        if (pending.load(std::memory_order_relaxed))
+            install_filter();
+
         if (!filtering) return true;
 
         // Maybe apply filter
@@ -173,15 +281,41 @@ private:
 
     std::thread* thr;
 
+    // Interface name.
+    std::string name;
+
+    // Capture statistics, sampled from pcap_stats.
+    util::metrics::gauge& received;
+    util::metrics::gauge& dropped;
+    util::metrics::gauge& if_dropped;
+
+    // Samples pcap_stats into the metrics.
+    void update_stats();
+
 public:
 
     // Thread body.
     virtual void run();
 
     // Constructor.  i=interface name, d=packet consumer.
-    interface(const std::string& i, float delay, packet_consumer& d) :
+    interface(const std::string& i, float delay, packet_consumer& d,
+	      uint64_t buffer = default_buffer,
+	      overflow_policy overflow = SPILL) :
 	cyberprobe::pcap::interface(*this, i),
-        delayline(d, delay, pcap_datalink(p))
+        delayline(d, delay, pcap_datalink(p), i, buffer, overflow),
+        name(i),
+        received(util::metrics::get_registry().get_gauge(
+                     "cyberprobe_capture_received_packets",
+                     "Packets received by the capture, from pcap_stats",
+                     {{"interface", i}})),
+        dropped(util::metrics::get_registry().get_gauge(
+                    "cyberprobe_capture_dropped_packets",
+                    "Packets dropped by the capture buffer, from pcap_stats",
+                    {{"interface", i}})),
+        if_dropped(util::metrics::get_registry().get_gauge(
+                       "cyberprobe_capture_interface_dropped_packets",
+                       "Packets dropped by the interface, from pcap_stats",
+                       {{"interface", i}}))
         {
             thr = 0;
         }
@@ -205,6 +339,14 @@ public:
 	thr = new std::thread(&interface::run, this);
     }
 
+    // The new filter is swapped in by the capture thread, pcap_setfilter
+    // replaces the kernel filter in one step.
+    virtual bool reconfigure(const std::string& filter, float delay) {
+        replace_filter(filter);
+        set_delay(delay);
+        return true;
+    }
+
      // Packet handler.
     virtual void handle(timeval tv, unsigned long len,
 			const unsigned char* bytes) {
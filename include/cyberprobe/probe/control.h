@@ -80,16 +80,22 @@ namespace control {
 	void cmd_targets();
 	void cmd_interfaces();
 	void cmd_parameters();
+	void cmd_metrics();
 	void cmd_add_interface(const json& j);
 	void cmd_remove_interface(const json& j);
 	void cmd_add_target(const json& j);
 	void cmd_remove_target(const json& j);
+	bool cmd_load_targets(const json& j);
+	void cmd_target_changes(const json& j);
 	void cmd_add_endpoint(const json& j);
 	void cmd_remove_endpoint(const json& j);
 	void cmd_auth(const json& j);
 	void cmd_add_parameter(const json& j);
 	void cmd_remove_parameter(const json& j);
 
+	// Reads a target in the binary load-targets form.
+	void read_target(target::spec& sp);
+
 	// OK response.
 	void ok(int status, const std::string& msg);
 
@@ -30,8 +30,10 @@ public:
     virtual void run();
 
     // Constructor.  i=interface name, d=packet consumer.
-    dag_dev(const std::string& i, float delay, packet_consumer& d) :
-        filtering_dev(d, delay, DLT_EN10MB) {
+    dag_dev(const std::string& i, float delay, packet_consumer& d,
+            uint64_t buffer = default_buffer,
+            overflow_policy overflow = SPILL) :
+        filtering_dev(d, delay, DLT_EN10MB, i, buffer, overflow) {
         this->iface = i;
         this->running = true;
     }
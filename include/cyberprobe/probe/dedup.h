@@ -0,0 +1,150 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// DUPLICATE PACKET RESOURCE
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <cyberprobe/resources/specification.h>
+#include <cyberprobe/resources/resource.h>
+#include <nlohmann/json.h>
+
+#include <sys/time.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+
+namespace cyberprobe {
+
+namespace probe {
+
+class delivery;
+
+namespace dedup {
+
+    using json = nlohmann::json;
+
+    // Remembers recently seen IP packets, so that a packet captured on
+    // more than one tap is only delivered once.  A packet is identified
+    // by a hash of its IP header, leaving out TTL / hop limit, the ECN
+    // bits and the IPv4 header checksum which change hop by hop, plus the
+    // start of the payload, which covers the TCP or UDP header and its
+    // checksum.
+    //
+    // The table is buckets of 4 slots, each slot holding 40 bits of hash
+    // and a 24-bit capture time in milliseconds.  Slots are read and
+    // written without locks.  When threads race, a duplicate can get
+    // through, but a packet is only dropped if its hash has been seen.
+    class table {
+    private:
+
+	// One cache-line-friendly bucket.
+	class alignas(32) bucket {
+	public:
+	    std::atomic<uint64_t> slot[4];
+	};
+
+	std::unique_ptr<bucket[]> buckets;
+	uint64_t mask;
+
+	// Window in milliseconds.
+	std::atomic<int32_t> window;
+
+	// Payload bytes hashed after the IP header.
+	static const unsigned int payload_bytes = 64;
+
+    public:
+
+	typedef std::vector<unsigned char>::const_iterator const_iterator;
+
+	// Constructor.  'slots' is rounded up to a power of 2.
+	table(float window, uint64_t slots);
+
+	void set_window(float window);
+
+	uint64_t size() const { return (mask + 1) * 4; }
+
+	// The size a table asked for 'slots' has.
+	static uint64_t round(uint64_t slots);
+
+	// Forgets everything.
+	void clear();
+
+	// Returns true if the IP packet [s, e) was seen within the window
+	// of its capture time, otherwise records it.
+	bool duplicate(const timeval& tv, const_iterator s, const_iterator e);
+
+    };
+
+    // Duplicate packet dropping specification.
+    class spec : public resources::specification {
+    public:
+
+	// Type is 'dedup'.
+	virtual std::string get_type() const { return "dedup"; }
+
+	// Window, seconds.  Copies captured further apart are delivered.
+	float window;
+
+	// Table slots.
+	uint64_t table_size;
+
+	static const uint64_t default_table_size = 262144;
+
+	// Constructors.
+	spec() : window(0.01), table_size(default_table_size) {}
+	spec(float window, uint64_t table_size = default_table_size) :
+	    window(window), table_size(table_size) {}
+
+	// Hash is the JSON form of the spec.
+	virtual std::string get_hash() const;
+
+	// There's only one, changes are made in place.
+	virtual std::string get_key() const { return "dedup"; }
+
+    };
+
+    // Duplicate packet dropping resource, turns the delivery engine's
+    // duplicate check on and off.
+    class filter : public resources::resource {
+    private:
+
+	// Specification.
+	const spec* sp;
+
+	// Reference to the delivery engine.
+	delivery& deliv;
+
+    public:
+
+	// Constructor.
+	filter(const spec& sp, delivery& d) : sp(&sp), deliv(d) {}
+
+	virtual void start();
+
+	virtual void stop();
+
+	// Window and table size changes, without letting duplicates
+	// through in between.
+	virtual bool update(resources::specification& spec);
+
+    };
+
+    void to_json(json& j, const spec& s);
+
+    void from_json(const json& j, spec& s);
+
+}
+
+}
+
+}
+
+#endif
+
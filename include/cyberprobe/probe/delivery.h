@@ -12,6 +12,7 @@
 #include <cyberprobe/probe/endpoint.h>
 #include <cyberprobe/probe/target.h>
 #include <cyberprobe/probe/parameter.h>
+#include <cyberprobe/probe/dedup.h>
 #include <cyberprobe/protocol/pdu.h>
 
 #include <map>
@@ -19,6 +20,8 @@
 #include <algorithm>
 #include <memory>
 #include <mutex>
+#include <deque>
+#include <atomic>
 
 namespace cyberprobe {
 
@@ -120,6 +123,38 @@ private:
     util::address_map<tcpip::ip4_address, match_state> targets;
     util::address_map<tcpip::ip6_address, match_state> targets6;
 
+    // Held while the target tables are changed, so that changes are made
+    // one at a time.  Capture threads only change the match state in the
+    // tables, never the keys, device or network, so with this held,
+    // those can be read without the targets lock.  Also guards the
+    // targets version and change log, which capture doesn't use.
+    std::mutex targets_update_mutex;
+
+    // Targets which have seen traffic, and so have match state, by
+    // address and mask.  Bulk changes visit only these with the targets
+    // lock held.  May hold targets which have since gone.
+    std::vector<std::pair<tcpip::ip4_address, unsigned int> > live_targets;
+    std::vector<std::pair<tcpip::ip6_address, unsigned int> > live_targets6;
+
+    // Target changes, so that get_target_changes can return a delta.  The
+    // version goes up with each change, and the log holds the most recent
+    // changes.  The log is complete from version targets_floor, a replace
+    // clears it.
+    class target_change {
+    public:
+	uint64_t version;
+	bool added;
+	target::spec sp;
+    };
+    uint64_t targets_version;
+    uint64_t targets_floor;
+    std::deque<target_change> target_log;
+    static const size_t max_target_log = 262144;
+
+    // Records a change in the log.  Called with the targets update lock
+    // held.
+    void log_target(bool added, const target::spec& sp);
+
     // Endpoints
     std::mutex senders_mutex;
     std::map<endpoint::spec, sender*> senders;
@@ -128,6 +163,15 @@ private:
     std::mutex interfaces_mutex;
     std::map<interface::spec, capture::device*> interfaces;
 
+    // Duplicate check, null when off.  Capture threads use the table
+    // without a lock, so tables which have been replaced are never freed.
+    // One is kept for each size asked for, and re-used if that size is
+    // asked for again, so memory grows with the number of different
+    // sizes used, not the number of changes.
+    std::atomic<dedup::table*> dups;
+    std::mutex dedup_mutex;
+    std::list<std::unique_ptr<dedup::table> > dedup_tables;
+
     // Parameters and lock
     std::mutex parameters_mutex;
     std::map<std::string, std::string> parameters;
@@ -158,6 +202,16 @@ private:
                     direction& direc,
 		    const link_info&);
 
+    // Duplicate check, counts against the packet's capture.
+    bool duplicate(timeval tv, const_iterator start, const_iterator end,
+		   packet_source& src);
+
+    // Creates a sender for an endpoint, not yet started.
+    sender* create_sender(const endpoint::spec& sp);
+
+    // Seconds a replaced sender gets to empty its queue.
+    static const unsigned int replace_drain_secs = 5;
+
     // Expand device/network template
     static void expand_template(const std::string& in,
 				std::string& out,
@@ -173,6 +227,12 @@ public:
     // Modifies interface capture
     virtual void remove_interface(const interface::spec& sp);
 
+    // Changes the filter and delay of a running capture, without stopping
+    // it.  Returns false if anything else has changed, or the capture
+    // can't be changed in place, and so needs to be restarted.
+    virtual bool update_interface(const interface::spec& old,
+				  const interface::spec& sp);
+
     // Returns the interfaces list.
     virtual void get_interfaces(std::list<interface::spec>& ii);
 
@@ -192,7 +252,7 @@ public:
 
     // Constructor: Specify the hostname and port number of the NHIS
     // recipient endpoint.
-    delivery() {}
+    delivery() : targets_version(0), targets_floor(0), dups(0) {}
 
     // Destructor.
     virtual ~delivery() {}
@@ -200,7 +260,11 @@ public:
     // Allows caller to provide an IP packet for delivery.
     virtual void receive_packet(timeval tv,
 				const std::vector<unsigned char>& packet,
-				int datalink);
+				int datalink, packet_source& src);
+
+    // Drops target packets already seen within 'window' seconds, e.g. on
+    // another tap.  A zero window turns it off.
+    void set_dedup(float window, uint64_t table_size);
 
     // Modifies the target map to include a mapping from address to target.
     void add_target(const target::spec& sp);
@@ -210,6 +274,19 @@ public:
 
     // Fetch current target list.
     virtual void get_targets(std::list<target::spec>& sp);
+    virtual void get_targets(std::list<target::spec>& sp,
+			     uint64_t& version);
+
+    // Bulk target changes.  The new tables are built without the targets
+    // lock, and swapped in.
+    virtual uint64_t update_targets(target_op op,
+				    const std::list<target::spec>& lst);
+
+    // Target changes since a version.
+    virtual bool get_target_changes(
+	uint64_t since,
+	std::list<std::pair<bool, target::spec> >& changes,
+	uint64_t& version);
 
     // Adds an endpoint
     virtual void add_endpoint(const endpoint::spec& sp);
@@ -217,6 +294,13 @@ public:
     // Removes an endpoint
     virtual void remove_endpoint(const endpoint::spec& sp);
 
+    // Replaces an endpoint.  The new sender is started and takes over
+    // delivery before the old one is stopped, the old one gets a few
+    // seconds to send what it has queued.  Returns false if the two can't
+    // run at once, because they share a spool.
+    virtual bool replace_endpoint(const endpoint::spec& old,
+				  const endpoint::spec& sp);
+
     // Fetch current target list.
     virtual void get_endpoints(std::list<endpoint::spec>& info);
 
@@ -9,6 +9,8 @@
 #define ENDPOINT_H
 
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 #include <cyberprobe/resources/specification.h>
 #include <cyberprobe/resources/resource.h>
@@ -34,14 +36,26 @@ namespace endpoint {
         // Endpoint parameters.
         std::string hostname;       // Hostname or IP address.
         unsigned short port;        // Port number.
-        std::string type;           // One of: etsi, nhis.
+        std::string type;           // One of: etsi, nhis, etsi-fanout.
         std::string transport;	// One of: tcp, tls.
+
+        // For etsi-fanout, the collectors' host and port.  hostname and
+        // port aren't used.
+        std::vector<std::pair<std::string, unsigned short> > collectors;
     
         // Parameters for TLS.
         std::string certificate_file;
         std::string key_file;
         std::string trusted_ca_file;
 
+        // Overflow spool file, empty for none.  Size limit in bytes, and
+        // drain rate in PDUs/second, 0 for no limit.
+        std::string spool;
+        uint64_t spool_max_size = default_spool_max_size;
+        unsigned int spool_drain_rate = 0;
+
+        static const uint64_t default_spool_max_size = 1073741824;
+
         // Constructors.
         spec() {}
         spec(const std::string& hostname, unsigned short port,
@@ -56,6 +70,10 @@ namespace endpoint {
         // Hash is form <space> + host:port.
         virtual std::string get_hash() const;
 
+        // Key is where PDUs go, host:port or the collector list.  Other
+        // changes replace the sender without a gap in delivery.
+        virtual std::string get_key() const;
+
         bool operator<(const spec& i) const {
 
             if (hostname < i.hostname)
@@ -84,6 +102,22 @@ namespace endpoint {
 
             if (trusted_ca_file < i.trusted_ca_file)
                 return true;
+            else if (trusted_ca_file > i.trusted_ca_file) return false;
+
+            if (collectors < i.collectors)
+                return true;
+            else if (collectors > i.collectors) return false;
+
+            if (spool < i.spool)
+                return true;
+            else if (spool > i.spool) return false;
+
+            if (spool_max_size < i.spool_max_size)
+                return true;
+            else if (spool_max_size > i.spool_max_size) return false;
+
+            if (spool_drain_rate < i.spool_drain_rate)
+                return true;
 
             return false;
 
@@ -97,7 +131,7 @@ namespace endpoint {
     private:
 
         // Spec.
-        const spec& sp;
+        const spec* sp;
 
         // Delivery engine reference.
         delivery& deliv;
@@ -106,7 +140,7 @@ namespace endpoint {
 
         // Constructor.
         endpoint(const spec& sp, delivery& d) : 
-            sp(sp), deliv(d) { }
+            sp(&sp), deliv(d) { }
 
         // Start method, change the delivery engine mapping.
         virtual void start();
@@ -114,6 +148,10 @@ namespace endpoint {
         // Stop method, remove the mapping.
         virtual void stop();
 
+        // Replaces the sender, the new one is running before the old one
+        // stops.
+        virtual bool update(cyberprobe::resources::specification& spec);
+
     };
 
     void to_json(json& j, const spec& s);
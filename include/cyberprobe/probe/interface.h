@@ -41,13 +41,38 @@ namespace interface {
         // Delay
         float delay;
 
+        // Delay buffer size, bytes.
+        uint64_t delay_buffer;
+
+        // Delay buffer overflow policy, one of: drop, spill.
+        std::string delay_overflow;
+
+        // Receive threads, VXLAN only.
+        unsigned int threads;
+
         // Constructors.
-        spec() {}
-        spec(const std::string& ifa) { this->ifa = ifa; delay = 0.0; }
+        spec() : delay(0.0),
+                 delay_buffer(capture::delayline::default_buffer),
+                 delay_overflow("spill"), threads(1) {}
+        spec(const std::string& ifa) :
+            ifa(ifa), delay(0.0),
+            delay_buffer(capture::delayline::default_buffer),
+            delay_overflow("spill"), threads(1) {}
+
+        // Overflow policy in delay line form.
+        capture::delayline::overflow_policy get_overflow() const {
+            if (delay_overflow == "drop")
+                return capture::delayline::DROP;
+            return capture::delayline::SPILL;
+        }
 
-        // Hash is <interface>:<filter>:<delay>
+        // Hash is the JSON form of the spec.
         virtual std::string get_hash() const;
 
+        // Key is the interface name, so filter and delay changes can be
+        // made to the running capture.
+        virtual std::string get_key() const { return ifa; }
+
         bool operator<(const spec& i) const {
 
             if (ifa < i.ifa)
@@ -60,6 +85,18 @@ namespace interface {
 
             if (delay < i.delay)
                 return true;
+            else if (delay > i.delay) return false;
+
+            if (delay_buffer < i.delay_buffer)
+                return true;
+            else if (delay_buffer > i.delay_buffer) return false;
+
+            if (delay_overflow < i.delay_overflow)
+                return true;
+            else if (delay_overflow > i.delay_overflow) return false;
+
+            if (threads < i.threads)
+                return true;
 
             return false;
 
@@ -73,7 +110,7 @@ namespace interface {
     private:
 
         // Specification.
-        const spec& sp;
+        const spec* sp;
 
         // Reference to the delivery engine.
         delivery& deliv;
@@ -82,7 +119,7 @@ namespace interface {
 
         // Constructor.
         iface(const spec& sp, delivery& d) : 
-            sp(sp), deliv(d) {}
+            sp(&sp), deliv(d) {}
 
         // Start method.
         virtual void start();
@@ -90,6 +127,9 @@ namespace interface {
         // Stop method.
         virtual void stop();
 
+        // Applies filter and delay changes to the running capture.
+        virtual bool update(cyberprobe::resources::specification& spec);
+
     };
 
     void to_json(json& j, const spec& s);
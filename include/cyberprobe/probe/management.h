@@ -4,6 +4,7 @@
 
 #include <list>
 #include <map>
+#include <stdint.h>
 
 #include "interface.h"
 #include "endpoint.h"
@@ -39,6 +40,27 @@ public:
     virtual void 
     get_targets(std::list<target::spec>& sp) = 0;
 
+    // Fetch current target list, and the targets version it's at.
+    virtual void get_targets(std::list<target::spec>& sp,
+                             uint64_t& version) = 0;
+
+    // Bulk target changes.
+    enum target_op { ADD_TARGETS, REMOVE_TARGETS, REPLACE_TARGETS };
+
+    // Adds, removes, or replaces all targets with, a list of targets, as
+    // one change.  Returns the targets version after the change.
+    virtual uint64_t update_targets(target_op op,
+                                    const std::list<target::spec>& lst) = 0;
+
+    // Fetches the target changes since version 'since', in order, and the
+    // version now.  Each change is true for an add, false for a remove.
+    // Returns false if the changes are no longer known, in which case the
+    // whole list has to be fetched.
+    virtual bool get_target_changes(
+        uint64_t since,
+        std::list<std::pair<bool, target::spec> >& changes,
+        uint64_t& version) = 0;
+
     // Adds an endpoint
     virtual void add_endpoint(const endpoint::spec&) = 0;
 
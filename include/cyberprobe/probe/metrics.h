@@ -0,0 +1,87 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// METRICS RESOURCE
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cyberprobe/resources/specification.h>
+#include <cyberprobe/resources/resource.h>
+#include <cyberprobe/util/metrics_server.h>
+#include <nlohmann/json.h>
+
+#include <sstream>
+
+namespace cyberprobe {
+
+namespace probe {
+
+namespace metrics {
+
+    using json = nlohmann::json;
+
+    // Metrics endpoint specification.
+    class spec : public resources::specification {
+    public:
+
+	// Type is 'metrics'.
+	virtual std::string get_type() const { return "metrics"; }
+
+	// Port to serve Prometheus metrics on.
+	int port;
+
+	// Constructors.
+	spec() {}
+	spec(unsigned short port) { this->port = port; }
+
+	// Hash is the port.
+	virtual std::string get_hash() const {
+	    std::ostringstream buf;
+	    buf << port;
+	    return buf.str();
+	}
+
+    };
+
+    // Metrics resource, wraps the HTTP metrics service.
+    class service : public resources::resource {
+    private:
+
+	// Resource specification.
+	spec& sp;
+
+	util::metrics::server svr;
+
+    public:
+
+	// Constructor.
+	service(spec& s) : sp(s), svr(s.port) {}
+
+	virtual void start() {
+	    std::cerr << "Starting metrics on port " << sp.port << std::endl;
+	    svr.start();
+	}
+
+	virtual void stop() {
+	    svr.stop();
+	    std::cerr << "Metrics on port " << sp.port << " stopped."
+		      << std::endl;
+	}
+
+    };
+
+    void to_json(json& j, const spec& s);
+
+    void from_json(const json& j, spec& s);
+
+}
+
+}
+
+}
+
+#endif
+
@@ -2,15 +2,41 @@
 #ifndef PACKET_CONSUMER_H
 #define PACKET_CONSUMER_H
 
+#include <cyberprobe/util/metrics.h>
+
 #include <sys/time.h>
 
+#include <string>
+#include <vector>
+
+// Where packets come from.  Each capture has one, labelled with its
+// interface, which the consumer uses for per-capture counts.
+class packet_source {
+public:
+
+    // Packets checked for duplicates, and duplicates dropped.
+    cyberprobe::util::metrics::counter& dedup_checked;
+    cyberprobe::util::metrics::counter& dedup_dropped;
+
+    packet_source(const std::string& name) :
+	dedup_checked(cyberprobe::util::metrics::get_registry().get_counter(
+			  "cyberprobe_dedup_packets_total",
+			  "Target packets checked for duplicates",
+			  {{"interface", name}})),
+	dedup_dropped(cyberprobe::util::metrics::get_registry().get_counter(
+			  "cyberprobe_dedup_duplicates_total",
+			  "Duplicate packets dropped",
+			  {{"interface", name}})) {}
+
+};
+
 class packet_consumer {
 public:
     virtual ~packet_consumer() {}
 
     // Allows caller to provide an IP packet for delivery.
     virtual void receive_packet(timeval tv, const std::vector<unsigned char>& packet,
-				int datalink) = 0;
+				int datalink, packet_source& src) = 0;
 
 };
 
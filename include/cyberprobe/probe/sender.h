@@ -3,6 +3,8 @@
 #define SENDER_H
 
 #include <queue>
+#include <deque>
+#include <set>
 #include <memory>
 #include <sys/time.h>
 
@@ -11,10 +13,14 @@
 #include <cyberprobe/stream/etsi_li.h>
 #include <cyberprobe/probe/management.h>
 #include <cyberprobe/probe/parameterised.h>
+#include <cyberprobe/probe/spool.h>
+#include <cyberprobe/util/metrics.h>
 
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <chrono>
+#include <atomic>
 
 namespace cyberprobe {
 
@@ -49,21 +55,107 @@ protected:
     static const unsigned int max_packets = 1024;
     std::queue<qpdu_ptr> packets;
 
+    // True while the thread is handling a PDU taken off the queue, and
+    // notified when it's done with the queue empty.
+    bool handling;
+    std::condition_variable idle;
+
     // State: true if we're running, false if we've been asked to stop.
-    bool running;
+    std::atomic<bool> running;
 
     parameterised& global_pars;
 
     std::thread* thr;
 
+    // Metrics, labelled with the endpoint.
+    util::metrics::gauge& queue_depth;
+    util::metrics::counter& queue_full;
+    util::metrics::counter& bytes_sent;
+    util::metrics::counter& pdus_sent;
+    util::metrics::counter& connects;
+    util::metrics::counter& failures;
+
+    // Overflow spool, null unless configured.  PDUs go here when the
+    // queue is full, and are drained at up to drain_rate PDUs/sec (0 for
+    // no limit) alongside live traffic.
+    std::unique_ptr<probe::spool> overflow;
+    unsigned int drain_rate;
+    double drain_tokens;
+    std::chrono::steady_clock::time_point drain_last;
+
+    // Where the last drain stopped looking, and the devices whose PDUs
+    // it skipped to get there, as they weren't ready.  Everything
+    // spooled ahead of drain_pos belongs to one of those devices.
+    uint64_t drain_pos;
+    std::set<std::string> drain_skipped;
+
+    // Spool metrics, created when the spool is.
+    util::metrics::labels metric_labels;
+    util::metrics::gauge* spool_bytes;
+    util::metrics::gauge* spool_pdus;
+    util::metrics::gauge* spool_oldest;
+    util::metrics::counter* spool_spilled;
+    util::metrics::counter* spool_full;
+
+    // Writes a PDU to the spool.  Returns false if there's no spool, or
+    // no room in it.
+    bool spill(const timeval& tv, const std::string& device,
+	       const std::string& network, direction dir,
+	       probe::spool::const_iterator start,
+	       probe::spool::const_iterator end);
+
+    // Sends the oldest spooled PDU of a device which is ready for it, if
+    // the drain rate allows.  Returns true if a PDU was sent.
+    bool drain();
+
+    // Returns false if 'handle' can't take a PDU for 'device' without
+    // waiting, so that its spooled PDUs stay spooled until it can.
+    virtual bool ready(const std::string& device) { return true; }
+
+    void update_spool_metrics();
+
+    // Short-hand for endpoint-labelled metrics.
+    static util::metrics::labels endpoint_labels(const std::string& h,
+						 unsigned short p) {
+	return {{"endpoint", h + ":" + std::to_string(p)}};
+    }
+
 public:
 
-    // Constructor.
-    sender(parameterised& p) : global_pars(p) {
+    // Constructor.  'l' labels the sender's metrics.
+    sender(parameterised& p, const util::metrics::labels& l) :
+	global_pars(p),
+	queue_depth(util::metrics::get_registry().get_gauge(
+			"cyberprobe_sender_queue_depth",
+			"PDUs waiting on the sender queue", l)),
+	queue_full(util::metrics::get_registry().get_counter(
+		       "cyberprobe_sender_queue_full_total",
+		       "Times delivery waited for queue space", l)),
+	bytes_sent(util::metrics::get_registry().get_counter(
+		       "cyberprobe_sender_bytes_total",
+		       "PDU bytes delivered to the endpoint", l)),
+	pdus_sent(util::metrics::get_registry().get_counter(
+		      "cyberprobe_sender_pdus_total",
+		      "PDUs delivered to the endpoint", l)),
+	connects(util::metrics::get_registry().get_counter(
+		     "cyberprobe_sender_connects_total",
+		     "Connections established to the endpoint", l)),
+	failures(util::metrics::get_registry().get_counter(
+		     "cyberprobe_sender_failures_total",
+		     "Connection or transmit failures", l)),
+	drain_rate(0), drain_tokens(0), drain_pos(0), metric_labels(l),
+	spool_bytes(0), spool_pdus(0), spool_oldest(0),
+	spool_spilled(0), spool_full(0) {
 	running = true;
+	handling = false;
 	thr = 0;
     }
 
+    // Spools overflow to 'path', up to 'max_size' bytes.  Must be called
+    // before start.  Throws if the spool can't be opened.
+    virtual void set_spool(const std::string& path, uint64_t max_size,
+			   unsigned int drain_rate);
+
     virtual void start() {
 	thr = new std::thread(&sender::run, this);
     }
@@ -88,12 +180,17 @@ public:
 			     std::shared_ptr<std::string> n);
 
     // Called to push a packet down the sender transport.
-    void deliver(timeval tv,
-                 std::shared_ptr<std::string> device,
-		 std::shared_ptr<std::string> n,
-                 direction dir,
-		 const_iterator& start,
-		 const_iterator& end);
+    virtual void deliver(timeval tv,
+			 std::shared_ptr<std::string> device,
+			 std::shared_ptr<std::string> n,
+			 direction dir,
+			 const_iterator& start,
+			 const_iterator& end);
+
+    // Waits until 'until' for the queued PDUs to be handled, so that a
+    // sender being replaced can finish what it has.  Returns true if
+    // they were.
+    virtual bool finish(std::chrono::steady_clock::time_point until);
 
     // Called to stop the thread.
     virtual void stop() {
@@ -101,6 +198,7 @@ public:
 
 	std::unique_lock<std::mutex> lk(mutex);
 	cond.notify_all();
+	idle.notify_all();
     }
 
     virtual void join() {
@@ -114,11 +212,39 @@ public:
 // state of the NHIS 1.1 connection, re-connecting if required.
 // This is a thread: You should create, called 'connect', call 'start' to
 // spawn the thread, then call 'deliver' when you have packets to transmit.
+// NHIS 1.1 has a connection per device, so the sender thread hands PDUs to
+// a lane per device, each with its own queue, connection and thread.  A
+// device whose connection is down backs off on its own, without holding
+// up the others.  Once its lane is full, its PDUs go to the spool, or
+// without one, the sender thread waits for the lane.
 class nhis11_sender : public sender {
 private:
 
-    // NHIS 1.1 transport.
-    std::map<std::string,cyberprobe::nhis11::sender> transport;
+    // A device's queue, NHIS 1.1 transport and thread.
+    class lane {
+    public:
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::condition_variable space;
+	std::deque<qpdu_ptr> packets;
+	bool sending;
+	cyberprobe::nhis11::sender transport;
+	std::chrono::milliseconds backoff;
+	std::thread* thr;
+	lane() : sending(false), backoff(0), thr(0) {}
+	~lane() { delete thr; }
+    };
+
+    // PDUs queued for one device.
+    static const unsigned int max_lane_packets = 1024;
+
+    // Reconnect backoff, doubling from initial to max on each failure.
+    static const unsigned int initial_backoff_ms = 100;
+    static const unsigned int max_backoff_ms = 30000;
+
+    // Lanes by device.
+    std::mutex lanes_mutex;
+    std::map<std::string, std::unique_ptr<lane> > lanes;
 
     // Connection details, host, port, transport.
     std::string h;
@@ -128,6 +254,17 @@ private:
     // Params
     std::map<std::string, std::string> params;
 
+    // Returns the device's lane, starting it if it's new.  Returns null
+    // if stopping.
+    lane* get_lane(const std::string& device);
+
+    // Lane thread body.
+    void run_lane(std::string device, lane* l);
+
+    // Sends a PDU on a lane, connecting first if needed.  Returns false
+    // on failure, with the connection closed.
+    bool send(const std::string& device, lane& l, qpdu_ptr next);
+
 public:
 
     // Constructor.
@@ -135,7 +272,7 @@ public:
 		  const std::string& transp,
 		  const std::map<std::string, std::string>& params,
 		  parameterised& globals) :
-        sender(globals), h(h), p(p), params(params) {
+        sender(globals, endpoint_labels(h, p)), h(h), p(p), params(params) {
 	if (transp == "tls")
 	    tls = true;
 	else if (transp == "tcp")
@@ -147,9 +284,18 @@ public:
     // Destructor.
     virtual ~nhis11_sender() {}
 
-    // PDU handler
+    // PDU handler, queues the PDU on the device's lane.
     virtual void handle(qpdu_ptr);
 
+    // True if the device's lane has room.
+    virtual bool ready(const std::string& device);
+
+    // Waits for the queue, then every lane, to be sent.
+    virtual bool finish(std::chrono::steady_clock::time_point until);
+
+    virtual void stop();
+    virtual void join();
+
     // Short-hand
     typedef std::vector<unsigned char>::const_iterator const_iterator;
 
@@ -206,7 +352,8 @@ public:
                    const std::string& transp,
 		   const std::map<std::string, std::string>& params,
 		   parameterised& globals) :
-        sender(globals), h(h), p(p), params(params), cur_connect(0)
+        sender(globals, endpoint_labels(h, p)), h(h), p(p), params(params),
+	cur_connect(0)
         {
 
             // Get value of etsi-streams parameter, default is 12.
@@ -244,6 +391,79 @@ public:
 
 };
 
+// Spreads packets across a set of ETSI LI collectors, so that a busy
+// device can be analysed by several cybermon instances.  Packets are
+// placed by a symmetric hash of the IP addresses, protocol and ports, so
+// both directions of a flow go to the same collector.  Collectors sit
+// on a consistent hash ring, so changing the collector list only moves
+// the flows of the collectors added or removed.  Target up/down goes to
+// every collector.
+class etsi_fanout_sender : public sender {
+public:
+
+    typedef std::pair<std::string, unsigned short> collector;
+
+    // Ring points per collector.  More points give a more even spread.
+    static const unsigned int ring_points = 100;
+
+private:
+
+    // One ETSI sender per collector.
+    std::vector<etsi_li_sender*> senders;
+
+    // Collector names, host:port, in the same order.
+    std::vector<std::string> names;
+
+    // Consistent hash ring, point to index in senders.
+    std::map<uint64_t, unsigned int> ring;
+
+    static std::string collector_names(const std::vector<collector>& c);
+
+public:
+
+    // Constructor.
+    etsi_fanout_sender(const std::vector<collector>& collectors,
+		       const std::string& transp,
+		       const std::map<std::string, std::string>& params,
+		       parameterised& globals);
+
+    // Destructor.
+    virtual ~etsi_fanout_sender();
+
+    // Symmetric flow hash of an IP packet.
+    static uint64_t flow_hash(const_iterator start, const_iterator end);
+
+    // Starts the collector senders, there's no thread of our own.
+    virtual void start();
+
+    // Packets go straight to a collector sender's queue.
+    virtual void handle(qpdu_ptr) {}
+
+    virtual void deliver(timeval tv,
+			 std::shared_ptr<std::string> device,
+			 std::shared_ptr<std::string> n,
+			 direction dir,
+			 const_iterator& start,
+			 const_iterator& end);
+
+    virtual void target_up(std::shared_ptr<std::string> l,
+			   std::shared_ptr<std::string> n,
+			   const tcpip::address& a);
+    virtual void target_down(std::shared_ptr<std::string> device,
+			     std::shared_ptr<std::string> n);
+
+    // Each collector gets its own spool, named after the collector.
+    virtual void set_spool(const std::string& path, uint64_t max_size,
+			   unsigned int drain_rate);
+
+    // Waits for every collector sender to finish.
+    virtual bool finish(std::chrono::steady_clock::time_point until);
+
+    virtual void stop();
+    virtual void join();
+
+};
+
 };
 
 #endif
@@ -0,0 +1,169 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Delivery spool.  A memory-mapped ring file which takes PDUs an
+// endpoint's sender can't queue in memory, e.g. while the collector is
+// unreachable.  PDUs are read back oldest first, and stay in the file
+// until popped, so the spool survives a restart.  A PDU further back can
+// be taken out ahead of older ones, which then stay where they are.  Once the reader has
+// freed at least as much space as is still spooled, writing goes back
+// to the start of the file, so a spool which is draining while capture
+// still feeds it re-uses its space.  Otherwise the file grows as needed
+// up to a size limit, and is truncated back when it empties.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_PROBE_SPOOL_H
+#define CYBERPROBE_PROBE_SPOOL_H
+
+#include <stdint.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include <cyberprobe/protocol/pdu.h>
+
+namespace cyberprobe {
+
+namespace probe {
+
+    class spool {
+    public:
+
+	typedef std::vector<unsigned char>::const_iterator const_iterator;
+
+	// A PDU read back from the spool.
+	class record {
+	public:
+	    timeval tv;
+	    protocol::direction dir;
+	    std::string device;
+	    std::string network;
+	    std::vector<unsigned char> pdu;
+	};
+
+	// Opens or creates the spool file.  Anything already spooled is
+	// kept.  Throws on error.
+	spool(const std::string& path, uint64_t max_size);
+
+	~spool();
+
+	// Appends a PDU.  Returns false if the spool is full.
+	bool push(const timeval& tv, const std::string& device,
+		  const std::string& network, protocol::direction dir,
+		  const_iterator s, const_iterator e);
+
+	// Copies out the oldest PDU, which stays spooled until pop is
+	// called.  Returns false if the spool is empty.
+	bool front(record& r);
+
+	// Discards the oldest PDU.
+	void pop();
+
+	// Finds the first PDU at or after position 'pos', 0 being the
+	// oldest.  Sets 'pos' to its position, 'next' to the position after
+	// it, and 'device' to its device.  Returns false if there's none.
+	// Positions stay good until the oldest PDU is popped or removed.
+	bool scan(uint64_t& pos, uint64_t& next, std::string& device);
+
+	// Copies out the PDU at 'pos'.  Returns false if there's none.
+	bool get(uint64_t pos, record& r);
+
+	// Discards the PDU at 'pos'.  Its space is only re-used once the
+	// PDUs ahead of it are gone too.
+	void remove(uint64_t pos);
+
+	// PDUs spooled, and bytes the spool takes up.
+	uint64_t count();
+	uint64_t bytes();
+
+	// Time of the oldest PDU.  Returns false if the spool is empty.
+	bool oldest(timeval& tv);
+
+    private:
+
+	// Start of the file.  When 'wrap' is zero, records lie between
+	// 'read' and 'write'.  Otherwise writing has gone back to the
+	// start: records lie between 'read' and 'wrap', then between
+	// data_start and 'write'.
+	struct header {
+	    char magic[8];
+	    uint64_t read;
+	    uint64_t write;
+	    uint64_t count;
+	    uint64_t wrap;
+	};
+
+	// Precedes each PDU, followed by the device, network and PDU
+	// bytes.  Records are padded to 8 bytes.  A removed record has
+	// the 'removed' bit set in 'dir'.
+	struct record_header {
+	    uint32_t length;
+	    uint16_t device_len;
+	    uint16_t network_len;
+	    int64_t sec;
+	    int64_t usec;
+	    uint32_t dir;
+	    uint32_t pdu_len;
+	};
+
+	static const uint32_t removed = 0x80000000;
+
+	// Records start here, leaving the first page to the header.
+	static const uint64_t data_start = 4096;
+
+	// File size when empty, and the size it is truncated back to.
+	static const uint64_t initial_size = 1024 * 1024;
+
+	std::string path;
+	uint64_t max_size;
+
+	std::mutex mutex;
+	int fd;
+	unsigned char* base;
+	uint64_t mapped;
+
+	header& hdr() { return *reinterpret_cast<header*>(base); }
+
+	// Resizes the file, and maps it again.  On error, throws with the
+	// old mapping still in place.
+	void remap(uint64_t size);
+
+	// Grows the file to at least 'need' bytes, within the size limit.
+	// Returns false if it can't.
+	bool grow(uint64_t need);
+
+	// Finds room for a record of 'len' bytes at the write offset, going
+	// back to the start of the file or growing it.  Returns false if
+	// there's none.
+	bool make_room(uint64_t len);
+
+	// Moves the read offset back to the start once it reaches the
+	// wrap point, and starts afresh once the spool is empty.
+	void advance();
+
+	// Moves the read offset past removed records, so that the oldest
+	// record is always one which is still spooled.
+	void skip_removed();
+
+	// File offset of position 'pos'.  Positions count bytes from the
+	// read offset, so don't change when the records at the start of the
+	// file are moved to follow the others.
+	uint64_t offset(uint64_t pos);
+
+	// Bytes between the read and write offsets.
+	uint64_t used();
+
+	// Reads the record at file offset 'off'.
+	void read_record(uint64_t off, record& r);
+
+    };
+
+}
+
+}
+
+#endif
+
@@ -7,18 +7,23 @@
 #include <sys/time.h>
 
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 namespace cyberprobe {
 
 namespace capture {
 
-// Packet capture.  Captures on an interface, and then submits captured
-// packets to the delivery engine.
-class vxlan : public filtering_device {
+// One VXLAN receive socket and thread, with its own delay line.
+class vxlan_worker : public filtering_device {
 private:
 
     unsigned short port;
-    bool running;
+    std::atomic<bool> running;
+
+    // True if the port is shared with other workers.
+    bool reuseport;
 
     std::thread* thr;
 
@@ -27,34 +32,103 @@ public:
     // Thread body.
     virtual void run();
 
-    // Constructor.  i=interface name, d=packet consumer.
-    vxlan(unsigned short port, float delay, packet_consumer& d) :
-        filtering_device(d, delay, DLT_EN10MB) {
-        this->port = port;
-        this->running = true;
+    // Constructor.  name labels the delay line metrics.
+    vxlan_worker(unsigned short port, bool reuseport, float delay,
+                 packet_consumer& d, const std::string& name,
+                 uint64_t buffer, overflow_policy overflow) :
+        filtering_device(d, delay, DLT_EN10MB, name, buffer, overflow),
+        port(port), running(true), reuseport(reuseport), thr(0) {}
+
+    // Destructor.  The thread uses this object, so it's stopped before
+    // anything is freed.
+    virtual ~vxlan_worker() {
+        stop();
+        join();
+        delete thr;
     }
 
-    // Destructor.
-    virtual ~vxlan() {}
-
     virtual void stop() {
 	running = false;
     }
 
     virtual void join() {
-	if (thr)
+	if (thr && thr->joinable())
 	    thr->join();
     }
     
     virtual void start() {
-	thr = new std::thread(&vxlan::run, this);
+	thr = new std::thread(&vxlan_worker::run, this);
     }
 
 };
 
+// VXLAN capture.  Receives VXLAN on a UDP port, and then submits captured
+// packets to the delivery engine.  With more than one thread, each has its
+// own SO_REUSEPORT socket, the kernel spreads datagrams across them.
+class vxlan : public device {
+private:
+
+    std::vector<std::shared_ptr<vxlan_worker> > workers;
+
+public:
+
+    // Constructor.  'threads' is the number of receive sockets/threads,
+    // the delay buffer is shared out between them.
+    vxlan(unsigned short port, float delay, packet_consumer& d,
+          uint64_t buffer = delayline::default_buffer,
+          delayline::overflow_policy overflow = delayline::SPILL,
+          unsigned int threads = 1) {
+
+        if (threads < 1) threads = 1;
+
+        std::string name = "vxlan:" + std::to_string(port);
+
+        for(unsigned int i = 0; i < threads; i++)
+            workers.push_back(std::make_shared<vxlan_worker>(
+                                  port, threads > 1, delay, d,
+                                  threads > 1 ?
+                                  name + "/" + std::to_string(i) : name,
+                                  buffer / threads, overflow));
+
+    }
+
+    // Destructor.  Stops all the workers before joining any, so they
+    // shut down together.
+    virtual ~vxlan() {
+        stop();
+        join();
+    }
+
+    virtual void add_filter(const std::string& spec) {
+        for(auto& w : workers)
+            w->add_filter(spec);
+    }
+
+    virtual bool reconfigure(const std::string& filter, float delay) {
+        for(auto& w : workers)
+            w->reconfigure(filter, delay);
+        return true;
+    }
+
+    virtual void stop() {
+        for(auto& w : workers)
+            w->stop();
+    }
+
+    virtual void join() {
+        for(auto& w : workers)
+            w->join();
+    }
+    
+    virtual void start() {
+        for(auto& w : workers)
+            w->start();
+    }
+
 };
 
 };
 
-#endif
+};
 
+#endif
@@ -6,6 +6,7 @@
 #include <memory>
 #include <map>
 #include <mutex>
+#include <atomic>
 
 #include <cyberprobe/protocol/flow.h>
 #include <cyberprobe/exception.h>
@@ -23,6 +24,50 @@ namespace protocol {
     // Shared pointer types.
     typedef std::shared_ptr<base_context> context_ptr;
 
+    // Context type tags, one per context class.
+    enum context_type {
+	ROOT_CONTEXT,
+	IP4_CONTEXT,
+	IP6_CONTEXT,
+	TCP_CONTEXT,
+	UDP_CONTEXT,
+	ICMP_CONTEXT,
+	GRE_CONTEXT,
+	ESP_CONTEXT,
+	WLAN_CONTEXT,
+	TLS_CONTEXT,
+	DNS_CONTEXT,
+	NTP_CONTEXT,
+	HTTP_REQUEST_CONTEXT,
+	HTTP_RESPONSE_CONTEXT,
+	FTP_CLIENT_CONTEXT,
+	FTP_SERVER_CONTEXT,
+	SMTP_CLIENT_CONTEXT,
+	SMTP_SERVER_CONTEXT,
+	SMTP_AUTH_CONTEXT,
+	IMAP_CONTEXT,
+	IMAP_SSL_CONTEXT,
+	POP3_CONTEXT,
+	POP3_SSL_CONTEXT,
+	RTP_CONTEXT,
+	SIP_CONTEXT,
+	UNRECOGNISED_STREAM_CONTEXT,
+	UNRECOGNISED_DATAGRAM_CONTEXT
+    };
+
+    // Context type names, indexed by context_type.
+    constexpr const char* context_type_names[] = {
+	"root", "ip4", "ip6", "tcp", "udp", "icmp", "gre", "esp", "802.11",
+	"tls", "dns", "ntp", "http_request", "http_response", "ftp_client",
+	"ftp_server", "smtp_client", "smtp_server", "smtp_auth", "imap",
+	"imap_ssl", "pop3", "pop3_ssl", "rtp", "sip", "unrecognised_stream",
+	"unrecognised_datagram"
+    };
+
+    static_assert(sizeof(context_type_names) / sizeof(const char*) ==
+		  UNRECOGNISED_DATAGRAM_CONTEXT + 1,
+		  "context_type_names doesn't match context_type");
+
     // Context class, describes the state around a 'flow' of data between
     // two endpoints at a particular network layer.
     class base_context {
@@ -30,11 +75,14 @@ namespace protocol {
 
 	// Next context ID to hand out.
 	static context_id next_context_id;
-	static unsigned long total_contexts;
+	static std::atomic<unsigned long> total_contexts;
 
 	// This context's ID.
 	context_id id;
 
+	// This context's type.
+	const context_type type;
+
     public:
 
 	// Time of creation.
@@ -84,14 +132,14 @@ namespace protocol {
 	std::map<flow_address,context_ptr> children;
 
 	// Constructor.
-        base_context() { 
+        base_context(context_type t) : type(t) { 
 	    id = next_context_id++; 
 	    total_contexts++;
 	    // parent is initialised to 'null'.
 	}
 
 	// Constructor, initialises parent pointer.
-        base_context(context_ptr parent) {
+        base_context(context_type t, context_ptr parent) : type(t) {
 	    id = next_context_id++; 
 	    this->parent = parent;
 	    total_contexts++;
@@ -122,8 +170,26 @@ namespace protocol {
 	// Returns constructor ID.
 	context_id get_id() { return id; }
 
-	// Returns a context 'type'.
-	virtual std::string get_type() = 0;
+	// Returns the number of contexts currently alive.
+	static unsigned long get_total_contexts() {
+	    return total_contexts.load(std::memory_order_relaxed);
+	}
+
+	// Returns the context type tag.
+	context_type get_context_type() const { return type; }
+
+	// Returns the context type name e.g. "tcp".  Prefer
+	// get_context_type for comparisons.
+	std::string get_type() const { return context_type_names[type]; }
+
+	// Downcasts to context class C, whose tag is 't'.  Checks the tag
+	// rather than using RTTI, returns null if it doesn't match.
+	template<class C>
+	static std::shared_ptr<C> tag_cast(const context_ptr& c,
+					   context_type t) {
+	    if (!c || c->type != t) return std::shared_ptr<C>();
+	    return std::static_pointer_cast<C>(c);
+	}
 
 	// Delete myself.
 	void delete_myself() {
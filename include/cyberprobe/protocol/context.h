@@ -41,12 +41,13 @@ namespace protocol {
 	static const int default_ttl = 120;
 
 	// Constructor.
-        context(manager& m) : reapable(m), mgr(m) { 
+        context(manager& m, context_type t) :
+            base_context(t), reapable(m), mgr(m) { 
 	}
 
 	// Constructor, initialises parent pointer.
-        context(manager& m, context_ptr parent) : 
-            base_context(parent), reapable(m), mgr(m) { 
+        context(manager& m, context_type t, context_ptr parent) : 
+            base_context(t, parent), reapable(m), mgr(m) { 
 	}
 
 #ifdef BROKEN
@@ -110,15 +111,48 @@ namespace protocol {
 	virtual ~context() { 
 	}
 
-	// Delete myself.
+	// Delete myself.  Called by the reaper without its lock held, so
+	// taking context locks here can't deadlock against a thread which
+	// holds a context lock and calls set_ttl.
 	void reap() {
 
 	    // Erase myself from my parent's child map.
-	    // Should call my destructor, I guess.
 	    context_ptr p = parent.lock();
-	    if (p)
-		p->children.erase(addr);
+	    if (!p) return;
 
+	    // Keeps me alive until the parent's lock is released, so the
+	    // destructors don't run under it.
+	    context_ptr self;
+
+	    {
+
+		std::lock_guard<std::mutex> lock(p->mutex);
+
+		auto it = p->children.find(addr);
+		if (it == p->children.end()) return;
+
+		self = it->second;
+
+		// Report flows while the context can still be found.
+		// Locks are taken parent first, as everywhere else.
+		if (mgr.flow_records())
+		    expire_flows(self);
+
+		p->children.erase(it);
+
+	    }
+
+	}
+
+	// Reports flow records for this context and its children, which
+	// are about to go.  Contexts which keep flow counters extend this.
+	virtual void expire_flows(context_ptr self) {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    for(auto& ch : children) {
+		// Every context class derives from context.
+		context* c = static_cast<context*>(ch.second.get());
+		c->expire_flows(ch.second);
+	    }
 	}
 
 	typedef context_ptr (*creator)(manager&, const flow_address&, 
@@ -129,7 +163,7 @@ namespace protocol {
 					 creator create_fn) {
 
 	    std::shared_ptr<context> mc = 
-		std::dynamic_pointer_cast<context>(parent);
+		std::static_pointer_cast<context>(parent);
 
 	    std::lock_guard<std::mutex> lock(mc->mutex);
 
@@ -177,7 +211,7 @@ namespace protocol {
 		    // Only do this on a root context, otherwise we'll just
 		    // find the same context in many cases.
 
-		    if ((parent->get_type() == "root") && 
+		    if ((parent->get_context_type() == ROOT_CONTEXT) && 
 			(parent->children.find(f_rev) != parent->children.end())) {
 
 			// If the parent's reverse has such a child, use that
@@ -220,7 +254,7 @@ namespace protocol {
     public:
 
         root_context(manager& m) : 
-            context(m) {
+            context(m, ROOT_CONTEXT) {
 	    addr.src.layer = ROOT;
 	    addr.dest.layer = ROOT;
 	}
@@ -255,7 +289,6 @@ namespace protocol {
 	    network = n;
 	}
 
-	virtual std::string get_type() { return "root"; }
     };
 
 }
@@ -0,0 +1,66 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Flow accounting.  Packet, byte and timing counters kept on transport
+// (and bare IP) contexts, reported as flow_record events when the
+// context expires, or periodically for long-lived flows.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_PROTOCOL_FLOW_COUNTERS_H
+#define CYBERPROBE_PROTOCOL_FLOW_COUNTERS_H
+
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+
+#include <cyberprobe/protocol/base_context.h>
+#include <cyberprobe/protocol/manager.h>
+#include <cyberprobe/protocol/pdu.h>
+
+namespace cyberprobe {
+namespace protocol {
+
+    class flow_counters {
+    private:
+
+	// Counters have their own lock, so they can be updated without
+	// regard to the context lock, and reported from the reaper.
+	std::mutex mutex;
+
+	// Since the last report.
+	uint64_t packets;
+	uint64_t bytes;
+	timeval first;
+	timeval last;
+
+	// TCP flags seen, OR'd together.
+	uint8_t tcp_flags;
+
+	// Reports the counters and resets them.  Called with the lock held,
+	// the lock is released before the event is handed over.
+	void report(manager& mgr, context_ptr c,
+		    std::unique_lock<std::mutex>& lock,
+		    const std::string& reason);
+
+    public:
+
+	flow_counters() : packets(0), bytes(0), tcp_flags(0) {}
+
+	// Counts a PDU on context 'c'.  Reports the flow so far if the
+	// manager's active timeout has passed since the first packet
+	// counted.  Does nothing unless flow accounting is on.
+	void count(manager& mgr, context_ptr c, const pdu_slice& sl,
+		   uint8_t flags = 0);
+
+	// Reports anything not yet reported, the flow has gone idle.
+	void expire(manager& mgr, context_ptr c);
+
+    };
+
+}
+}
+
+#endif
+
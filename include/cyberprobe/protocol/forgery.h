@@ -48,6 +48,25 @@ namespace protocol {
 					 int flags,
 					 const pdu& payload);
 
+	static void encode_ip6_udp_header(pdu& p,
+					  address& src, uint16_t sport,
+					  address& dest, uint16_t dport,
+					  const pdu& payload);
+
+	static void encode_ip6_tcp_header(pdu& p,
+					  address& src, uint16_t sport,
+					  address& dest, uint16_t dport,
+					  uint32_t seq, uint32_t ack,
+					  int flags,
+					  const pdu& payload);
+
+    private:
+
+	// IPv6 header, the payload length covers the transport header.
+	static void encode_ip6_header(pdu& p,
+				      address& src, address& dest,
+				      uint8_t next, uint16_t length);
+
     };
 
 }
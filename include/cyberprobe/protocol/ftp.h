@@ -95,19 +95,16 @@ namespace protocol {
 	
 	// Constructor.
         ftp_client_context(manager& m) : 
-            context(m) {
+            context(m, FTP_CLIENT_CONTEXT) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         ftp_client_context(manager& m, const flow_address& a, 
                            context_ptr p) : 
-            context(m) { 
+            context(m, FTP_CLIENT_CONTEXT) { 
 	    addr = a; parent = p; 
 	}
 
-	// Type.
-	virtual std::string get_type() { return "ftp_client"; }
-
 	typedef std::shared_ptr<ftp_client_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f,
@@ -120,7 +117,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = 
 		context::get_or_create(base, f, ftp_client_context::create);
-	    ptr sp = std::dynamic_pointer_cast<ftp_client_context>(cp);
+	    ptr sp = tag_cast<ftp_client_context>(cp, FTP_CLIENT_CONTEXT);
 	    return sp;
 	}
 
@@ -132,19 +129,16 @@ namespace protocol {
 	
 	// Constructor.
         ftp_server_context(manager& m) : 
-            context(m) {
+            context(m, FTP_SERVER_CONTEXT) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         ftp_server_context(manager& m, const flow_address& a, 
                            context_ptr p) : 
-            context(m) { 
+            context(m, FTP_SERVER_CONTEXT) { 
 	    addr = a; parent = p; 
 	}
 
-	// Type.
-	virtual std::string get_type() { return "ftp_server"; }
-
 	typedef std::shared_ptr<ftp_server_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f,
@@ -157,7 +151,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = 
 		context::get_or_create(base, f, ftp_server_context::create);
-	    ptr sp = std::dynamic_pointer_cast<ftp_server_context>(cp);
+	    ptr sp = tag_cast<ftp_server_context>(cp, FTP_SERVER_CONTEXT);
 	    return sp;
 	}
 
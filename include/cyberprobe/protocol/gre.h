@@ -17,8 +17,6 @@ namespace protocol {
                     const flow_address& fAddr,
                     context_ptr ctxPtr);
 
-	virtual std::string get_type();
-
 	typedef std::shared_ptr<gre_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f,
@@ -31,7 +29,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
             context_ptr cp = context::get_or_create(base, f,
                                                     gre_context::create);
-            ptr sp = std::dynamic_pointer_cast<gre_context>(cp);
+            ptr sp = tag_cast<gre_context>(cp, GRE_CONTEXT);
             return sp;
 	}
     };
@@ -148,14 +148,16 @@ namespace protocol {
 
 	// Constructor.
         http_request_context(manager& m) :
-            context(m), http_parser(REQUEST), streaming_requested(false),
+            context(m, HTTP_REQUEST_CONTEXT), http_parser(REQUEST),
+            streaming_requested(false),
             streaming(false) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         http_request_context(manager& m, const flow_address& a,
 			     context_ptr p) :
-            context(m), http_parser(REQUEST), streaming_requested(false),
+            context(m, HTTP_REQUEST_CONTEXT), http_parser(REQUEST),
+            streaming_requested(false),
             streaming(false) {
 	    addr = a; parent = p;
 	}
@@ -165,9 +167,6 @@ namespace protocol {
         bool streaming_requested;
         bool streaming;
 
-	// Type.
-	virtual std::string get_type() { return "http_request"; }
-
 	typedef std::shared_ptr<http_request_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f,
@@ -180,7 +179,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp =
 		context::get_or_create(base, f, http_request_context::create);
-	    ptr sp = std::dynamic_pointer_cast<http_request_context>(cp);
+	    ptr sp = tag_cast<http_request_context>(cp, HTTP_REQUEST_CONTEXT);
 	    return sp;
 	}
 
@@ -192,19 +191,18 @@ namespace protocol {
 
 	// Constructor.
         http_response_context(manager& m) :
-            context(m), http_parser(RESPONSE), streaming(false) {
+            context(m, HTTP_RESPONSE_CONTEXT), http_parser(RESPONSE),
+            streaming(false) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         http_response_context(manager& m, const flow_address& a,
 			      context_ptr p) :
-            context(m), http_parser(RESPONSE), streaming(false) {
+            context(m, HTTP_RESPONSE_CONTEXT), http_parser(RESPONSE),
+            streaming(false) {
 	    addr = a; parent = p;
 	}
 
-	// Type.
-	virtual std::string get_type() { return "http_response"; }
-
 	typedef std::shared_ptr<http_response_context> ptr;
 
         bool streaming;
@@ -219,7 +217,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp =
 		context::get_or_create(base, f, http_response_context::create);
-	    ptr sp = std::dynamic_pointer_cast<http_response_context>(cp);
+	    ptr sp = tag_cast<http_response_context>(cp, HTTP_RESPONSE_CONTEXT);
 	    return sp;
 	}
 
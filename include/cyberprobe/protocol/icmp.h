@@ -12,13 +12,12 @@ namespace protocol {
     // ICMP.
     class icmp_context : public context {
     public:
-        icmp_context(manager& m) : context(m) {}
+        icmp_context(manager& m) : context(m, ICMP_CONTEXT) {}
         icmp_context(manager& m, const flow_address& a, context_ptr p) : 
-            context(m) {
+            context(m, ICMP_CONTEXT) {
             addr = a;
             parent = p; 
 	}
-	virtual std::string get_type() { return "icmp"; }
  
 	typedef std::shared_ptr<icmp_context> ptr;
 
@@ -32,7 +31,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = context::get_or_create(base, f, 
 						    icmp_context::create);
-	    ptr sp = std::dynamic_pointer_cast<icmp_context>(cp);
+	    ptr sp = tag_cast<icmp_context>(cp, ICMP_CONTEXT);
 	    return sp;
 	}
 
@@ -20,22 +20,16 @@ namespace protocol {
     public:
 
         // Constructor.
-        imap_context(manager& m) : context(m) {}
+        imap_context(manager& m) : context(m, IMAP_CONTEXT) {}
 
         // Constructor, when specifying flow address and parent context.
         imap_context(manager& m, const flow_address& a, context_ptr p)
-            : context(m)
+            : context(m, IMAP_CONTEXT)
             { 
                 addr = a;
                 parent = p; 
             }
 
-        // Type is "imap".
-        virtual std::string get_type()
-            {
-                return "imap";
-            }
-
         typedef std::shared_ptr<imap_context> ptr;
 
         static context_ptr create(manager& m, const flow_address& f, context_ptr par)
@@ -48,7 +42,7 @@ namespace protocol {
         static ptr get_or_create(context_ptr base, const flow_address& f)
             {
                 context_ptr cp = context::get_or_create(base, f, imap_context::create);
-                ptr sp = std::dynamic_pointer_cast<imap_context>(cp);
+                ptr sp = tag_cast<imap_context>(cp, IMAP_CONTEXT);
                 return sp;
             }
     };
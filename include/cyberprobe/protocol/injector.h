@@ -0,0 +1,94 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Packet injection.  Forged IP packets are queued, and written by a
+// background thread over long-lived raw sockets, one sendmmsg call per
+// batch.  IPv4 and IPv6 are supported.  The sockets are opened on first
+// use, so nothing needs raw socket privilege unless packets are forged.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_PROTOCOL_INJECTOR_H
+#define CYBERPROBE_PROTOCOL_INJECTOR_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include <cyberprobe/protocol/address.h>
+#include <cyberprobe/protocol/pdu.h>
+#include <cyberprobe/util/metrics.h>
+
+namespace cyberprobe {
+
+namespace protocol {
+
+    class injector {
+    public:
+
+	// Packets queued beyond this are dropped, and counted as failed.
+	static const unsigned int max_queue = 4096;
+
+	// Packets per sendmmsg call.
+	static const unsigned int batch = 64;
+
+	// The process-wide injector.
+	static injector& get();
+
+	// Sends on a particular interface, rather than the one routing
+	// picks.  Takes effect when the sockets are opened, so should be
+	// called before anything is forged.
+	void set_interface(const std::string& iface);
+
+	// Queues a packet, complete with IPv4 or IPv6 header, to be sent
+	// to 'dest'.  Throws if the raw socket can't be opened.
+	void send(pdu&& packet, const address& dest);
+
+	// Sends anything queued, and stops the sender thread.
+	void stop();
+
+	~injector();
+
+    private:
+
+	class packet {
+	public:
+	    pdu data;
+	    std::vector<unsigned char> dest;
+	};
+
+	injector();
+
+	std::string iface;
+
+	// Raw sockets, -1 until opened.
+	int sock4;
+	int sock6;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::vector<packet> queue;
+	bool running;
+	std::thread* thr;
+
+	util::metrics::counter& injected;
+	util::metrics::counter& failed;
+
+	// Opens a raw socket, IP header included.
+	int open(int family);
+
+	void run();
+
+	// Sends packets for one address family.
+	void flush(int sock, int family, std::vector<packet*>& pkts);
+
+    };
+
+}
+
+}
+
+#endif
+
@@ -6,6 +6,7 @@
 
 #include <cyberprobe/protocol/context.h>
 #include <cyberprobe/protocol/manager.h>
+#include <cyberprobe/protocol/flow_counters.h>
 
 #include <deque>
 
@@ -76,17 +77,22 @@ namespace protocol {
     public:
 
 	// Constructor.
-        ip4_context(manager& m) : context(m) {}
+        ip4_context(manager& m) : context(m, IP4_CONTEXT) {}
 
 	// Constructor, specifying flow address and parent.
         ip4_context(manager& m, const flow_address& a, context_ptr par) : 
-            context(m) { 
+            context(m, IP4_CONTEXT) { 
 	    parent = par;
 	    addr = a; 
 	}
 
-	// Type is "ip4".
-	virtual std::string get_type() { return "ip4"; }
+	// Flow accounting, for IP protocols without a transport context.
+	flow_counters flow;
+
+	virtual void expire_flows(context_ptr self) {
+	    flow.expire(mgr, self);
+	    context::expire_flows(self);
+	}
 
 	typedef std::shared_ptr<ip4_context> ptr;
 
@@ -100,7 +106,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = context::get_or_create(base, f, 
 						    ip4_context::create);
-	    ptr sp = std::dynamic_pointer_cast<ip4_context>(cp);
+	    ptr sp = tag_cast<ip4_context>(cp, IP4_CONTEXT);
 	    return sp;
 	}
 
@@ -114,17 +120,22 @@ namespace protocol {
     public:
 
 	// Constructor.
-        ip6_context(manager& m) : context(m) {}
+        ip6_context(manager& m) : context(m, IP6_CONTEXT) {}
 
 	// Constructor, specifying flow address and parent.
         ip6_context(manager& m, const flow_address& a, context_ptr par) : 
-            context(m) { 
+            context(m, IP6_CONTEXT) { 
 	    parent = par;
 	    addr = a; 
 	}
 
-	// Type is "ip6".
-	virtual std::string get_type() { return "ip6"; }
+	// Flow accounting, for IP protocols without a transport context.
+	flow_counters flow;
+
+	virtual void expire_flows(context_ptr self) {
+	    flow.expire(mgr, self);
+	    context::expire_flows(self);
+	}
 
 	typedef std::shared_ptr<ip6_context> ptr;
 
@@ -138,7 +149,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = context::get_or_create(base, f, 
 						    ip6_context::create);
-	    ptr sp = std::dynamic_pointer_cast<ip6_context>(cp);
+	    ptr sp = tag_cast<ip6_context>(cp, IP6_CONTEXT);
 	    return sp;
 	}
 
@@ -2,6 +2,11 @@
 #ifndef CYBERMON_ANALYSER_MANAGER_H
 #define CYBERMON_ANALYSER_MANAGER_H
 
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
 #include <cyberprobe/util/reaper.h>
 #include <cyberprobe/protocol/observer.h>
 
@@ -10,8 +15,52 @@ namespace cyberprobe {
     namespace protocol {
 
         class manager : public observer, public util::reaper {
+        protected:
+
+            // Bitmask of wanted events, bit N is set if events with
+            // action_type N are consumed.  Everything, by default.
+            uint64_t subscriptions;
+
+            // Stream depth limits in bytes per direction, keyed by
+            // protocol name, with "default" applying to protocols not
+            // listed.  Stream payload beyond the depth isn't processed.
+            std::map<std::string, uint64_t> stream_depths;
+
+            // Flow accounting, off by default.  Flow records are reported
+            // when a context expires, and every flow_active_timeout
+            // seconds for long-lived flows, 0 = only on expiry.
+            bool flow_accounting;
+            unsigned long flow_active_timeout;
+
         public:
 
+            manager() : subscriptions(~uint64_t(0)), flow_accounting(false),
+                        flow_active_timeout(0) {}
+
+            // Returns true if contexts should keep flow counters.
+            bool flow_records() const { return flow_accounting; }
+
+            // Flow active timeout in seconds, 0 = none.
+            unsigned long get_flow_active_timeout() const {
+                return flow_active_timeout;
+            }
+
+            // Returns the stream depth for a protocol, 0 = unlimited.
+            uint64_t get_stream_depth(const std::string& protocol) const {
+                auto it = stream_depths.find(protocol);
+                if (it != stream_depths.end()) return it->second;
+                it = stream_depths.find("default");
+                if (it != stream_depths.end()) return it->second;
+                return 0;
+            }
+
+            // Returns true if events of the given action_type are
+            // consumed.  Protocol handlers check this before building an
+            // event, and can skip work which only serves the event.
+            bool wants(int action) const {
+                return (subscriptions >> action) & 1;
+            }
+
         };
 
     }
@@ -19,4 +68,3 @@ namespace cyberprobe {
 }
 
 #endif
-
@@ -2,9 +2,11 @@
 #ifndef CYBERPROBE_ANALYSER_PDU_H
 #define CYBERPROBE_ANALYSER_PDU_H
 
-#include <vector>
+#include <string.h>
 #include <sys/time.h>
 
+#include <vector>
+
 namespace cyberprobe {
 
 namespace protocol {
@@ -36,6 +38,29 @@ namespace protocol {
 
     };
 
+    // Returns the first 'c' in [s, e), or e if there isn't one.  memchr
+    // scans a word or vector at a time, so parsers use this to find
+    // delimiters and take the run before it in one go.
+    inline pdu_iter find_byte(pdu_iter s, pdu_iter e, unsigned char c) {
+	if (s == e) return e;
+	const unsigned char* p = &*s;
+	const void* f = memchr(p, c, e - s);
+	if (f == 0) return e;
+	return s + (static_cast<const unsigned char*>(f) - p);
+    }
+
+    // Appends the bytes before the first 'c' to 'out', and moves 's' on to
+    // the 'c'.  Returns false if the slice ended first, in which case all
+    // of it was taken.
+    template<class T>
+    inline bool take_until(pdu_iter& s, pdu_iter e, unsigned char c,
+			   T& out) {
+	pdu_iter f = find_byte(s, e, c);
+	out.insert(out.end(), s, f);
+	s = f;
+	return s != e;
+    }
+
 };
 
 };
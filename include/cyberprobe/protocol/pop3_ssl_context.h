@@ -20,22 +20,16 @@ namespace protocol {
     public:
 
         // Construcotr.
-        pop3_ssl_context(manager& m) : context(m) {}
+        pop3_ssl_context(manager& m) : context(m, POP3_SSL_CONTEXT) {}
 
         // Constructor, when specifying flow address and parent context.
         pop3_ssl_context(manager& m, const flow_address& a, context_ptr p)
-            : context(m)
+            : context(m, POP3_SSL_CONTEXT)
             { 
                 addr = a;
                 parent = p; 
             }
 
-        // Type is "pop3_ssl".
-        virtual std::string get_type()
-            {
-                return "pop3_ssl";
-            }
-
         typedef std::shared_ptr<pop3_ssl_context> ptr;
 
         static context_ptr create(manager& m, const flow_address& f, context_ptr par)
@@ -48,7 +42,7 @@ namespace protocol {
         static ptr get_or_create(context_ptr base, const flow_address& f)
             {
                 context_ptr cp = context::get_or_create(base, f, pop3_ssl_context::create);
-                ptr sp = std::dynamic_pointer_cast<pop3_ssl_context>(cp);
+                ptr sp = tag_cast<pop3_ssl_context>(cp, POP3_SSL_CONTEXT);
                 return sp;
             }
     };
@@ -20,22 +20,16 @@ namespace protocol {
     public:
 
         // Constructor.
-        rtp_context(manager& m) : context(m) {}
+        rtp_context(manager& m) : context(m, RTP_CONTEXT) {}
 
         // Constructor, when specifying flow address and parent context.
         rtp_context(manager& m, const flow_address& a, context_ptr p)
-            : context(m)
+            : context(m, RTP_CONTEXT)
             { 
                 addr = a;
                 parent = p; 
             }
 
-        // Type is "rtp".
-        virtual std::string get_type()
-            {
-                return "rtp";
-            }
-
         typedef std::shared_ptr<rtp_context> ptr;
 
         static context_ptr create(manager& m, const flow_address& f, context_ptr par)
@@ -48,7 +42,7 @@ namespace protocol {
         static ptr get_or_create(context_ptr base, const flow_address& f)
             {
                 context_ptr cp = context::get_or_create(base, f, rtp_context::create);
-                ptr sp = std::dynamic_pointer_cast<rtp_context>(cp);
+                ptr sp = tag_cast<rtp_context>(cp, RTP_CONTEXT);
                 return sp;
             }
     };
@@ -27,8 +27,6 @@ namespace protocol {
         // Constructor, when specifying flow address and parent context.
         sip_context(manager& m, const flow_address& a, context_ptr p);
 
-        virtual std::string get_type();
-
         typedef std::shared_ptr<sip_context> ptr;
 
         static context_ptr create(manager& m, const flow_address& f, context_ptr par);
@@ -95,19 +95,16 @@ namespace protocol {
 	
 	// Constructor.
         smtp_client_context(manager& m) : 
-            context(m) {
+            context(m, SMTP_CLIENT_CONTEXT) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         smtp_client_context(manager& m, const flow_address& a, 
 			    context_ptr p) : 
-            context(m) { 
+            context(m, SMTP_CLIENT_CONTEXT) { 
 	    addr = a; parent = p; 
 	}
 
-	// Type.
-	virtual std::string get_type() { return "smtp_client"; }
-
 	typedef std::shared_ptr<smtp_client_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f,
@@ -120,7 +117,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = 
 		context::get_or_create(base, f, smtp_client_context::create);
-	    ptr sp = std::dynamic_pointer_cast<smtp_client_context>(cp);
+	    ptr sp = tag_cast<smtp_client_context>(cp, SMTP_CLIENT_CONTEXT);
 	    return sp;
 	}
 
@@ -132,19 +129,16 @@ namespace protocol {
 	
 	// Constructor.
         smtp_server_context(manager& m) : 
-            context(m) {
+            context(m, SMTP_SERVER_CONTEXT) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         smtp_server_context(manager& m, const flow_address& a, 
 			    context_ptr p) : 
-            context(m) { 
+            context(m, SMTP_SERVER_CONTEXT) { 
 	    addr = a; parent = p; 
 	}
 
-	// Type.
-	virtual std::string get_type() { return "smtp_server"; }
-
 	typedef std::shared_ptr<smtp_server_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f,
@@ -157,7 +151,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = 
 		context::get_or_create(base, f, smtp_server_context::create);
-	    ptr sp = std::dynamic_pointer_cast<smtp_server_context>(cp);
+	    ptr sp = tag_cast<smtp_server_context>(cp, SMTP_SERVER_CONTEXT);
 	    return sp;
 	}
 
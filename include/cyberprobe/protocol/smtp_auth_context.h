@@ -20,22 +20,16 @@ namespace protocol {
     public:
 
         // Constructor.
-        smtp_auth_context(manager& m) : context(m) {}
+        smtp_auth_context(manager& m) : context(m, SMTP_AUTH_CONTEXT) {}
 
         // Constructor, when specifying flow address and parent context.
         smtp_auth_context(manager& m, const flow_address& a, context_ptr p)
-            : context(m)
+            : context(m, SMTP_AUTH_CONTEXT)
             { 
                 addr = a;
                 parent = p; 
             }
 
-        // Type is "smtp_auth".
-        virtual std::string get_type()
-            {
-                return "smtp_auth";
-            }
-
         typedef std::shared_ptr<smtp_auth_context> ptr;
 
         static context_ptr create(manager& m, const flow_address& f, context_ptr par)
@@ -48,7 +42,7 @@ namespace protocol {
         static ptr get_or_create(context_ptr base, const flow_address& f)
             {
                 context_ptr cp = context::get_or_create(base, f, smtp_auth_context::create);
-                ptr sp = std::dynamic_pointer_cast<smtp_auth_context>(cp);
+                ptr sp = tag_cast<smtp_auth_context>(cp, SMTP_AUTH_CONTEXT);
                 return sp;
             }
     };
@@ -11,8 +11,11 @@
 #include <stdint.h>
 
 #include <set>
+#include <string>
+#include <mutex>
 
 #include <cyberprobe/protocol/context.h>
+#include <cyberprobe/protocol/flow_counters.h>
 #include <cyberprobe/protocol/manager.h>
 #include <cyberprobe/util/serial.h>
 #include <cyberprobe/protocol/process.h>
@@ -50,6 +53,15 @@ namespace protocol {
 	bool svc_idented;
 	process_fn processor;
 
+	// Stream depth for the identified protocol, 0 = unlimited.  Payload
+	// bytes seen so far, and whether the depth has been passed.
+	uint64_t depth;
+	uint64_t stream_bytes;
+	bool cut_off;
+
+	// Flow accounting.
+	flow_counters flow;
+
         typedef cyberprobe::util::serial<uint32_t, uint32_t> serial;
         
 	// Sequence number.
@@ -65,7 +77,7 @@ namespace protocol {
 
 	// Constructor, describing flow address and parent pointer.
         tcp_context(manager& m, const flow_address& a, context_ptr p)
-            : context(m) { 
+            : context(m, TCP_CONTEXT) { 
 	    addr = a;
 	    parent = p; 
 	    syn_observed = false;
@@ -73,6 +85,9 @@ namespace protocol {
 	    svc_idented = false;
 	    processor = 0;
 	    fin_observed = false;
+	    depth = 0;
+	    stream_bytes = 0;
+	    cut_off = false;
 
 	    // Only need to initialise handlers once
 	    if (!tcp_ports::is_handlers_init())
@@ -81,8 +96,10 @@ namespace protocol {
 		}
 	}
 
-	// Type is "tcp".
-	virtual std::string get_type() { return "tcp"; }
+	virtual void expire_flows(context_ptr self) {
+	    flow.expire(mgr, self);
+	    context::expire_flows(self);
+	}
 
 	typedef std::shared_ptr<tcp_context> ptr;
 
@@ -96,7 +113,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = context::get_or_create(base, f, 
 						    tcp_context::create);
-	    ptr sp = std::dynamic_pointer_cast<tcp_context>(cp);
+	    ptr sp = tag_cast<tcp_context>(cp, TCP_CONTEXT);
 	    return sp;
         }
 
@@ -118,6 +135,14 @@ namespace protocol {
 					    pdu_iter s,    // TCP hdr + body
 					    pdu_iter e);
 
+	// Calculate TCP or UDP cksum over IPv6
+	static uint16_t calculate_ip6_cksum(pdu_iter src,  // IPv6 address
+					    pdu_iter dest, // IPv6 address
+					    uint8_t protocol,
+					    uint32_t length,
+					    pdu_iter s,    // TCP hdr + body
+					    pdu_iter e);
+
 	// Flags
 	static const int FIN = 1;
 	static const int SYN = 2;
@@ -136,6 +161,17 @@ namespace protocol {
 	static void post_process(manager&, tcp_context::ptr c,
 				 const pdu_slice& sl);
 
+	// Protocol name of a stream processor, used to look up the stream
+	// depth.
+	static std::string protocol_name(process_fn p);
+
+    private:
+
+	// Passes identified stream data to the processor, enforcing the
+	// stream depth.  Called with the context lock held, releases it.
+	static void dispatch(manager&, tcp_context::ptr c, const pdu_slice& sl,
+			     std::unique_lock<std::mutex>& lock);
+
     };
 
 }
@@ -16,8 +16,6 @@ namespace protocol {
                     const flow_address& fAddr,
                     context_ptr ctxPtr);
 
-        virtual std::string get_type();
-
         typedef std::shared_ptr<tls_context> ptr;
 
         static context_ptr create(manager& m, const flow_address& f, context_ptr par)
@@ -29,7 +27,7 @@ namespace protocol {
         // Given a flow address, returns the child context.
         static ptr get_or_create(context_ptr base, const flow_address& f) {
             context_ptr cp = context::get_or_create(base, f, tls_context::create);
-            ptr sp = std::dynamic_pointer_cast<tls_context>(cp);
+            ptr sp = tag_cast<tls_context>(cp, TLS_CONTEXT);
             return sp;
         }
 
@@ -9,6 +9,7 @@
 #define CYBERMON_UDP_H
 
 #include <cyberprobe/protocol/context.h>
+#include <cyberprobe/protocol/flow_counters.h>
 #include <cyberprobe/protocol/manager.h>
 #include <cyberprobe/protocol/udp_ports.h>
 #include <cyberprobe/protocol/process.h>
@@ -26,9 +27,12 @@ namespace protocol {
         // Once identified, the processing function.
         process_fn processor;
 
+	// Flow accounting.
+	flow_counters flow;
+
         // Constructor, when specifying flow address and parent context.
         udp_context(manager& m, const flow_address& a, context_ptr p)
-            : context(m)
+            : context(m, UDP_CONTEXT)
             { 
                 addr = a;
                 parent = p; 
@@ -40,8 +44,10 @@ namespace protocol {
                     }
             }
 
-	// Type is "udp".
-	virtual std::string get_type() { return "udp"; }
+	virtual void expire_flows(context_ptr self) {
+	    flow.expire(mgr, self);
+	    context::expire_flows(self);
+	}
 
 	typedef std::shared_ptr<udp_context> ptr;
 
@@ -56,7 +62,7 @@ namespace protocol {
 	static ptr get_or_create(context_ptr base, const flow_address& f) {
 	    context_ptr cp = context::get_or_create(base, f, 
 						    udp_context::create);
-	    ptr sp = std::dynamic_pointer_cast<udp_context>(cp);
+	    ptr sp = tag_cast<udp_context>(cp, UDP_CONTEXT);
 	    return sp;
 	}
 
@@ -28,21 +28,18 @@ namespace protocol {
 	
 	// Constructor.
         unrecognised_stream_context(manager& m) : 
-            context(m) {
+            context(m, UNRECOGNISED_STREAM_CONTEXT) {
             position = 0;
 	}
 
 	// Constructor, describing flow address and parent pointer.
         unrecognised_stream_context(manager& m, const flow_address& a, 
 				    context_ptr p) : 
-            context(m) { 
+            context(m, UNRECOGNISED_STREAM_CONTEXT) { 
 	    addr = a; parent = p;
             position = 0;
 	}
 
-	// Type.
-	virtual std::string get_type() { return "unrecognised_stream"; }
-
 	typedef std::shared_ptr<unrecognised_stream_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f, 
@@ -58,7 +55,8 @@ namespace protocol {
 		context::get_or_create(base, f, 
 				       unrecognised_stream_context::create);
 	    ptr sp = 
-		std::dynamic_pointer_cast<unrecognised_stream_context>(cp);
+		tag_cast<unrecognised_stream_context>(cp,
+						      UNRECOGNISED_STREAM_CONTEXT);
 	    return sp;
 	}
 
@@ -72,19 +70,16 @@ namespace protocol {
 	
 	// Constructor.
         unrecognised_datagram_context(manager& m) : 
-            context(m) {
+            context(m, UNRECOGNISED_DATAGRAM_CONTEXT) {
 	}
 
 	// Constructor, describing flow address and parent pointer.
         unrecognised_datagram_context(manager& m, const flow_address& a, 
 				      context_ptr p) : 
-            context(m) { 
+            context(m, UNRECOGNISED_DATAGRAM_CONTEXT) { 
 	    addr = a; parent = p; 
 	}
 
-	// Type.
-	virtual std::string get_type() { return "unrecognised_datagram"; }
-
 	typedef std::shared_ptr<unrecognised_datagram_context> ptr;
 
 	static context_ptr create(manager& m, const flow_address& f, 
@@ -100,7 +95,8 @@ namespace protocol {
 		context::get_or_create(base, f, 
 				       unrecognised_datagram_context::create);
 	    ptr sp = 
-		std::dynamic_pointer_cast<unrecognised_datagram_context>(cp);
+		tag_cast<unrecognised_datagram_context>(
+		    cp, UNRECOGNISED_DATAGRAM_CONTEXT);
 	    return sp;
 	}
 
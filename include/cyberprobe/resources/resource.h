@@ -15,7 +15,8 @@
 //
 // - At least one class derived from the resource class.  These are
 //   instantiations of specifications.  You have to implement the 'start'
-//   and 'stop' methods to get it to start and stop the resource.
+//   and 'stop' methods to get it to start and stop the resource.  You can
+//   also implement 'update' to change a running resource in place.
 //
 // You then call the 'check' method on your resource manager periodically
 // to get it to check the configuration file for changes.
@@ -45,6 +46,13 @@ namespace resources {
         // Stop the resource.
         virtual void stop() = 0;
 
+        // Called when the specification changes, but its type and key are
+        // the same.  Returns true if the running resource has been changed
+        // to meet the new specification, which it should keep a reference
+        // to from then on.  Returns false if it should be stopped and
+        // re-created.
+        virtual bool update(specification& spec) { return false; }
+
         // Destructor.
         virtual ~resource() {}
     };
@@ -21,6 +21,13 @@ namespace resources {
         // resource_manager::create to work out which resource to create
         // for a specification.  Other than that, not used.
         virtual std::string get_type() const = 0;
+
+        // Returns a string identifying the resource, which stays the same
+        // when other parts of its description change, e.g. an interface
+        // name.  A resource whose key is unchanged can be updated in place
+        // rather than stopped and re-created.  Defaults to the hash, so
+        // that a changed specification is a new resource.
+        virtual std::string get_key() const { return get_hash(); }
     
         // Destructor.
         virtual ~specification() {}
@@ -0,0 +1,163 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Indexed packet archive.  Packets are written in blocks to a data file per
+// time partition (an hour by default), and each block gets an entry in the
+// partition's index file: where the block is, the time it covers, and a
+// Bloom filter of the IP addresses, flows and LIIDs in it, sized to the
+// number of different ones.  A query reads the index of the partitions in
+// its time range, and only reads the blocks whose Bloom filter matches.
+//
+// In directory DIR, partition starting at time T (seconds) is:
+//   DIR/T.data    Blocks of packet records.
+//   DIR/T.idx     Index entries, one per block.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_STREAM_ARCHIVE_H
+#define CYBERPROBE_STREAM_ARCHIVE_H
+
+#include <stdint.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <unordered_set>
+
+namespace cyberprobe {
+
+namespace archive {
+
+    typedef std::vector<unsigned char>::const_iterator const_iterator;
+
+    // Bloom filter bits per distinct key in a block, and hashes per key,
+    // for around 1% false positives.
+    static const unsigned int bloom_bits_per_key = 10;
+    static const unsigned int bloom_hashes = 7;
+
+    // Index entry, one per block, followed by 'bloom_bytes' of Bloom
+    // filter.
+    struct index_entry {
+	uint64_t offset;
+	uint32_t length;
+	uint32_t packets;
+	int64_t first;		// Seconds
+	int64_t last;
+	uint32_t bloom_bytes;
+	uint32_t hashes;
+    };
+
+    // Keys which are indexed.  A packet is indexed under its source and
+    // destination addresses, its flow, and the LIID.
+    class key {
+    public:
+
+	// An IP address, 4 or 16 bytes.
+	static std::string ip(const std::vector<unsigned char>& addr);
+
+	// A flow, the same both ways round.  Ports are ignored for
+	// protocols other than TCP and UDP.
+	static std::string flow(uint8_t proto,
+				const std::vector<unsigned char>& a,
+				uint16_t aport,
+				const std::vector<unsigned char>& b,
+				uint16_t bport);
+
+	static std::string liid(const std::string& liid);
+
+	// All the keys for a packet.  Returns false if it isn't IP.
+	static bool keys(const std::string& liid, const_iterator s,
+			 const_iterator e, std::vector<std::string>& keys);
+
+    };
+
+    // Writes the archive.  Safe to call from several threads.
+    class writer {
+    public:
+
+	// 'block_size' is roughly the bytes of packets per block,
+	// 'partition' the seconds per partition.
+	writer(const std::string& dir, uint32_t block_size = 1024 * 1024,
+	       unsigned int partition = 3600);
+
+	~writer();
+
+	void write(const std::string& liid, const timeval& tv,
+		   const_iterator s, const_iterator e);
+
+	// Writes the current block, even if not full.
+	void flush();
+
+	void close();
+
+    private:
+
+	std::string dir;
+	uint32_t block_size;
+	unsigned int partition;
+
+	std::mutex mutex;
+
+	// Open partition, -1 if none.
+	int64_t current;
+	int data_fd;
+	int index_fd;
+	uint64_t data_size;
+
+	// The block being filled, and hashes of its keys.
+	std::vector<unsigned char> block;
+	index_entry entry;
+	std::unordered_set<uint64_t> block_keys;
+
+	void open(int64_t part);
+	void write_block();
+
+    };
+
+    // A packet found by a query.
+    class packet {
+    public:
+	timeval tv;
+	std::string liid;
+	std::vector<unsigned char> data;
+    };
+
+    // Finds packets in an archive.
+    class query {
+    public:
+
+	query(const std::string& dir) : dir(dir), from(0), to(INT64_MAX) {}
+
+	// Restricts to packets with this IP address, flow or LIID.  Keys
+	// made with the key class.  With several keys, packets matching any
+	// of them are returned.
+	void add_key(const std::string& k) { keys.push_back(k); }
+
+	// Restricts to a time range, in seconds.
+	void set_time(int64_t f, int64_t t) { from = f; to = t; }
+
+	// Calls 'fn' on each matching packet, in time order within each
+	// partition.  Returns the number of blocks read.
+	unsigned int run(std::function<void(const packet&)> fn);
+
+    private:
+
+	std::string dir;
+	std::vector<std::string> keys;
+	int64_t from;
+	int64_t to;
+
+	bool matches(const index_entry& ent,
+		     const std::vector<uint8_t>& bloom) const;
+	bool matches(const packet& p) const;
+
+    };
+
+}
+
+}
+
+#endif
+
@@ -124,9 +124,7 @@ namespace stream {
             std::list<berpdu> contained_pdus;
             bool is_decoded;
 
-        public:
-            berpdu& get_element(int tag) {
-	    
+            void decode_elements() {
                 if (!is_decoded) {
                     if (!is_constructed()) 
                         throw std::out_of_range("Not a constructed PDU.");
@@ -134,6 +132,12 @@ namespace stream {
                     decode_construct(contained_pdus);
                     is_decoded = true;
                 }
+            }
+
+        public:
+            berpdu& get_element(int tag) {
+	    
+                decode_elements();
 
                 for(std::list<berpdu>::iterator it = contained_pdus.begin();
                     it != contained_pdus.end();
@@ -148,6 +152,23 @@ namespace stream {
 
             }
 
+            /** True if a constructed PDU has an element with the tag, for
+                optional elements, where get_element would throw. */
+            bool has_element(int tag) {
+
+                decode_elements();
+
+                for(std::list<berpdu>::iterator it = contained_pdus.begin();
+                    it != contained_pdus.end();
+                    it++) {
+                    if (it->get_tag() == tag)
+                        return true;
+                }
+
+                return false;
+
+            }
+
             long decode_tag(long& pos) const {
 
                 // Low order case.
@@ -433,9 +454,12 @@ namespace stream {
                 int start = content_start();
                 int length = get_length();
 
+                // Content is most significant byte first, integer<> is
+                // least significant first.
                 std::vector<unsigned char> vbytes;
-                std::copy(data->begin() + start, data->begin() + start + length,
-                          back_inserter(vbytes));
+                std::reverse_copy(data->begin() + start,
+                                  data->begin() + start + length,
+                                  back_inserter(vbytes));
 
                 i.decode(vbytes);
 
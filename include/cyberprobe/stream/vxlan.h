@@ -12,31 +12,45 @@ VXLAN reception support.
 #include <cyberprobe/analyser/monitor.h>
 
 #include <thread>
+#include <vector>
+#include <memory>
 
 namespace cyberprobe {
 
     namespace vxlan {
 
-        // VXLAN server.
+        // VXLAN server.  With more than one thread, each thread has its
+        // own SO_REUSEPORT socket, and the kernel spreads datagrams across
+        // them.
         class receiver {
 
         private:
             bool running;
             analyser::monitor& mon;
             
-            std::shared_ptr<tcpip::udp_socket> svr;
-	    std::thread* thr;
+            std::vector<std::shared_ptr<tcpip::udp_socket> > svrs;
+	    std::vector<std::thread*> thrs;
+
+            // Receive loop for a single socket.
+            virtual void run(std::shared_ptr<tcpip::udp_socket> svr);
 
         public:
 
             std::string device;
 
-            receiver(int port, analyser::monitor& mon) : mon(mon) {
+            receiver(int port, analyser::monitor& mon,
+                     unsigned int threads = 1) : mon(mon) {
                 running = true;
-                std::shared_ptr<tcpip::udp_socket> sock(new tcpip::udp_socket);
-                svr = sock;
-                svr->bind(port);
-		thr = nullptr;
+                if (threads < 1) threads = 1;
+                for(unsigned int i = 0; i < threads; i++) {
+                    std::shared_ptr<tcpip::udp_socket>
+                        sock(new tcpip::udp_socket);
+                    if (threads > 1)
+                        sock->set_reuseport();
+                    sock->set_timestamps();
+                    sock->bind(port);
+                    svrs.push_back(sock);
+                }
             }
 
             receiver(std::shared_ptr<tcpip::udp_socket> s,
@@ -44,21 +58,33 @@ namespace cyberprobe {
                 mon(mon)
                 {
                     running = true;
-                    svr = s;
-                    thr = nullptr;
+                    s->set_timestamps();
+                    svrs.push_back(s);
                 }
 
-            virtual ~receiver() {}
-            virtual void run();
+            virtual ~receiver() {
+                for(auto t : thrs)
+                    delete t;
+            }
+
+            // Runs the receive loop on the first socket, in the caller's
+            // thread.
+            virtual void run() {
+                run(svrs.front());
+            }
 
-	    // Boot thread.
+	    // Boot threads, one per socket.
 	    void start() {
-		thr = new std::thread(&receiver::run, this);
+                for(auto& s : svrs) {
+                    void (receiver::*fn)(std::shared_ptr<tcpip::udp_socket>)
+                        = &receiver::run;
+                    thrs.push_back(new std::thread(fn, this, s));
+                }
 	    }
 
 	    virtual void join() {
-		if (thr)
-		    thr->join();
+                for(auto t : thrs)
+                    t->join();
 	    }
 
 	    virtual void stop() {
@@ -45,13 +45,32 @@ public:
 
     // Removes a key from the map, address 'a', mask 'mark'.
     void remove(A a, unsigned int mask) {
-	m[mask].erase(a & mask);
+	typename mask_map::iterator it = m.find(mask);
+	if (it == m.end()) return;
+	it->second.erase(a & mask);
+	// An empty mask would still cost a lookup on every search.
+	if (it->second.empty())
+	    m.erase(it);
+    }
+
+    // Finds the value for exactly address 'a', mask 'mask', or returns 0.
+    T* find(const A& a, unsigned int mask) {
+	typename mask_map::iterator it = m.find(mask);
+	if (it == m.end()) return 0;
+	typename single_map::iterator it2 = it->second.find(a & mask);
+	if (it2 == it->second.end()) return 0;
+	return &it2->second;
+    }
+
+    void swap(address_map& other) {
+	m.swap(other.m);
     }
 
     // Searches the map for address 'a'.  If it exists, returns true and
     // a pointer to the value is returned in 't'.  Otherwise, returns false,
-    // and t is undefined.  The hit key is returned as 'hit'.
-    bool get(const A& a, T*& t, const A*& hit) {
+    // and t is undefined.  The hit key is returned as 'hit', and its mask
+    // as 'hit_mask'.
+    bool get(const A& a, T*& t, const A*& hit, unsigned int& hit_mask) {
       
 	typename mask_map::reverse_iterator it;
 
@@ -61,16 +80,12 @@ public:
 
 	    unsigned int mask = it->first;
 
-	    A th = a & mask;
-	    std::string th2;
-	    a.to_string(th2);
-	    th.to_string(th2);
-
 	    it2 = it->second.find(a & mask);
 
 	    if (it2 != it->second.end()) {
 		t = &it2->second;
 		hit = &it2->first;
+		hit_mask = mask;
 		return true;
 	    }
 	    
@@ -80,6 +95,14 @@ public:
 
     }
 
+    // Searches the map for address 'a'.  If it exists, returns true and
+    // a pointer to the value is returned in 't'.  Otherwise, returns false,
+    // and t is undefined.  The hit key is returned as 'hit'.
+    bool get(const A& a, T*& t, const A*& hit) {
+	unsigned int ignored;
+	return get(a, t, hit, ignored);
+    }
+
     // Searches the map for address 'a'.  If it exists, returns true and
     // a pointer to the value is returned in 't'.  Otherwise, returns false,
     // and t is undefined.
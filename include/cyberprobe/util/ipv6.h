@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// IPv6 extension header walking
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_UTIL_IPV6_H
+#define CYBERPROBE_UTIL_IPV6_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace cyberprobe {
+
+namespace util {
+
+    // Skips the extension headers of the IPv6 packet at 's', 'len' bytes
+    // long, which is at least the 40 byte fixed header.  Sets 'proto' to
+    // the protocol of the header which follows them, and 'hdr' to its
+    // offset.  Stops at a fragment header, after which only the first
+    // fragment has more headers: 'fragment' is set if there is one, and
+    // 'first' if it's the first fragment.  Stops early, leaving 'proto'
+    // as an extension header, if the packet is too short.
+    template <class I>
+    void ipv6_payload(I s, size_t len, uint8_t& proto, size_t& hdr,
+		      bool& fragment, bool& first)
+    {
+
+	proto = s[6];
+	hdr = 40;
+	fragment = false;
+	first = false;
+
+	while (len >= hdr + 8) {
+	    if (proto == 0 || proto == 43 || proto == 60) {
+		// Hop-by-hop, routing, destination options.
+		proto = s[hdr];
+		hdr += (s[hdr + 1] + 1) * 8;
+	    } else if (proto == 51) {
+		// Authentication header.
+		proto = s[hdr];
+		hdr += (s[hdr + 1] + 2) * 4;
+	    } else if (proto == 44) {
+		proto = s[hdr];
+		fragment = true;
+		first = ((s[hdr + 2] << 8) + (s[hdr + 3] & 0xf8)) == 0;
+		hdr += 8;
+		break;
+	    } else
+		break;
+	}
+
+    }
+
+}
+
+}
+
+#endif
+
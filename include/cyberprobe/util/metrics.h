@@ -0,0 +1,263 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Runtime metrics.  A process-wide registry of counters, gauges and
+// latency histograms.  Metrics are looked up (under a lock) once, and
+// the returned reference is then updated lock-free on the hot path, so
+// callers should cache the reference, e.g. in a function-local static or
+// a member.
+//
+// The registry renders in Prometheus text exposition format, and as JSON
+// for the management interface.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_UTIL_METRICS_H
+#define CYBERPROBE_UTIL_METRICS_H
+
+#include <atomic>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include <stdint.h>
+
+#include <nlohmann/json.h>
+
+namespace cyberprobe {
+
+namespace util {
+
+namespace metrics {
+
+    using json = nlohmann::json;
+
+    // Label set, name to value.
+    typedef std::map<std::string, std::string> labels;
+
+    // Base class for all metric types.
+    class metric {
+    public:
+	virtual ~metric() {}
+    };
+
+    // Counters and histograms are sharded across cache lines, each
+    // thread updates its own shard, so busy threads don't contend on a
+    // single atomic.  Reading merges the shards.
+    const unsigned int shards = 16;
+
+    // Returns the shard used by the calling thread.
+    inline unsigned int slot() {
+	static std::atomic<unsigned int> next(0);
+	thread_local unsigned int mine = next++ % shards;
+	return mine;
+    }
+
+    // Monotonic counter.
+    class counter : public metric {
+    private:
+	struct alignas(64) shard {
+	    std::atomic<uint64_t> v;
+	};
+	shard s[shards];
+
+    public:
+	counter() {
+	    for(unsigned int i = 0; i < shards; i++)
+		s[i].v.store(0, std::memory_order_relaxed);
+	}
+
+	void inc(uint64_t n = 1) {
+	    s[slot()].v.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	uint64_t value() const {
+	    uint64_t tot = 0;
+	    for(unsigned int i = 0; i < shards; i++)
+		tot += s[i].v.load(std::memory_order_relaxed);
+	    return tot;
+	}
+
+    };
+
+    // Gauge, a value which goes up and down.  Can alternatively be backed
+    // by a function, which is called when the value is read.
+    class gauge : public metric {
+    private:
+	std::atomic<int64_t> v;
+	std::function<double()> fn;
+    public:
+	gauge() : v(0) {}
+
+	void set(int64_t n) { v.store(n, std::memory_order_relaxed); }
+	void inc(int64_t n = 1) { v.fetch_add(n, std::memory_order_relaxed); }
+	void dec(int64_t n = 1) { v.fetch_sub(n, std::memory_order_relaxed); }
+
+	// Set function, must only be called once, before the gauge is
+	// read, and the function must remain valid for the life of the
+	// process.
+	void set_function(std::function<double()> f) { fn = f; }
+
+	double value() const {
+	    if (fn) return fn();
+	    return v.load(std::memory_order_relaxed);
+	}
+
+    };
+
+    // Latency histogram, values are recorded in nanoseconds.  Buckets are
+    // log-linear (HDR-style): each power of two is split into 8 linear
+    // sub-buckets, giving a worst-case relative error of 12.5% over the
+    // whole 64-bit range with a fixed 4KB footprint per shard.
+    class histogram : public metric {
+    public:
+	static const unsigned int sub_bits = 3;
+	static const unsigned int sub_buckets = 1 << sub_bits;
+	static const unsigned int num_buckets =
+	    (64 - sub_bits + 1) * sub_buckets;
+
+    private:
+	struct alignas(64) shard {
+	    std::atomic<uint64_t> buckets[num_buckets];
+	    std::atomic<uint64_t> total;
+	    std::atomic<uint64_t> sum;
+	};
+	shard s[shards];
+
+    public:
+	histogram() {
+	    for(unsigned int i = 0; i < shards; i++) {
+		for(unsigned int j = 0; j < num_buckets; j++)
+		    s[i].buckets[j].store(0, std::memory_order_relaxed);
+		s[i].total.store(0, std::memory_order_relaxed);
+		s[i].sum.store(0, std::memory_order_relaxed);
+	    }
+	}
+
+	// Maps a value to a bucket index.
+	static unsigned int bucket(uint64_t v) {
+	    if (v < sub_buckets) return v;
+	    unsigned int e = 63 - __builtin_clzll(v);
+	    return (e - sub_bits + 1) * sub_buckets +
+		((v >> (e - sub_bits)) - sub_buckets);
+	}
+
+	// Highest value which maps to a bucket.
+	static uint64_t bucket_upper(unsigned int b) {
+	    if (b < sub_buckets) return b;
+	    unsigned int g = b / sub_buckets - 1;
+	    uint64_t m = sub_buckets + b % sub_buckets;
+	    return ((m + 1) << g) - 1;
+	}
+
+	// Record a value, in nanoseconds.
+	void record(uint64_t ns) {
+	    shard& sh = s[slot()];
+	    sh.buckets[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+	    sh.total.fetch_add(1, std::memory_order_relaxed);
+	    sh.sum.fetch_add(ns, std::memory_order_relaxed);
+	}
+
+	// Record a duration.
+	template<class R, class P>
+	void record(const std::chrono::duration<R, P>& d) {
+	    record(std::chrono::duration_cast<std::chrono::nanoseconds>(d)
+		   .count());
+	}
+
+	uint64_t count() const {
+	    uint64_t tot = 0;
+	    for(unsigned int i = 0; i < shards; i++)
+		tot += s[i].total.load(std::memory_order_relaxed);
+	    return tot;
+	}
+
+	// Sum of recorded values, nanoseconds.
+	uint64_t total_ns() const {
+	    uint64_t tot = 0;
+	    for(unsigned int i = 0; i < shards; i++)
+		tot += s[i].sum.load(std::memory_order_relaxed);
+	    return tot;
+	}
+
+	// Returns quantile q (0..1) estimate in nanoseconds.
+	uint64_t quantile(double q) const;
+
+    };
+
+    // Times a scope, recording into a histogram on exit.  A timer which
+    // isn't 'on' doesn't read the clock, so that a hot path can time a
+    // sample of its calls.
+    class timer {
+    private:
+	histogram* h;
+	std::chrono::steady_clock::time_point start;
+    public:
+	timer(histogram& h, bool on = true) : h(on ? &h : 0) {
+	    if (on) start = std::chrono::steady_clock::now();
+	}
+	~timer() {
+	    if (h) h->record(std::chrono::steady_clock::now() - start);
+	}
+    };
+
+    // The metrics registry.
+    class registry {
+    private:
+
+	enum metric_type { COUNTER, GAUGE, HISTOGRAM };
+
+	// All metrics sharing a name.
+	class family {
+	public:
+	    metric_type type;
+	    std::string help;
+	    std::map<labels, std::unique_ptr<metric> > members;
+	};
+
+	std::mutex mutex;
+	std::map<std::string, family> families;
+
+	// Find or create a metric.
+	template<class M>
+	M& get(const std::string& name, const std::string& help,
+	       metric_type type, const labels& l);
+
+    public:
+
+	// The process-wide registry.
+	static registry& instance();
+
+	counter& get_counter(const std::string& name,
+			     const std::string& help,
+			     const labels& l = labels());
+
+	gauge& get_gauge(const std::string& name,
+			 const std::string& help,
+			 const labels& l = labels());
+
+	histogram& get_histogram(const std::string& name,
+				 const std::string& help,
+				 const labels& l = labels());
+
+	// Prometheus text exposition format.
+	void to_prometheus(std::string& out);
+
+	// JSON form, for the management interface.
+	void to_json(json& j);
+
+    };
+
+    // Short-hand for the process-wide registry.
+    inline registry& get_registry() { return registry::instance(); }
+
+}
+
+}
+
+}
+
+#endif
+
@@ -0,0 +1,80 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Minimal HTTP service exposing the metrics registry in Prometheus text
+// format on /metrics.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_UTIL_METRICS_SERVER_H
+#define CYBERPROBE_UTIL_METRICS_SERVER_H
+
+#include <cyberprobe/util/metrics.h>
+#include <cyberprobe/network/socket.h>
+
+#include <thread>
+
+namespace cyberprobe {
+
+namespace util {
+
+namespace metrics {
+
+    class server {
+    private:
+
+	// Port to listen on.
+	int port;
+
+	// TCP socket, accepting connections.
+	tcpip::tcp_socket svr;
+
+	// True = running, false = closing down.
+	bool running;
+
+	std::thread* thr;
+
+	// Handle a single HTTP request.
+	void serve(std::shared_ptr<tcpip::stream_socket> s);
+
+    public:
+
+	// Constructor.
+	server(int port) : port(port), running(true), thr(0) {}
+
+	// Destructor, stops the thread if it's still running.
+	virtual ~server() {
+	    if (thr && thr->joinable()) {
+		running = false;
+		thr->join();
+	    }
+	    delete thr;
+	}
+
+	// Thread body.
+	virtual void run();
+
+	virtual void start() {
+	    thr = new std::thread(&server::run, this);
+	}
+
+	virtual void stop() {
+	    running = false;
+	    join();
+	}
+
+	virtual void join() {
+	    if (thr && thr->joinable())
+		thr->join();
+	}
+
+    };
+
+}
+
+}
+
+}
+
+#endif
+
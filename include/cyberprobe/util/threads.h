@@ -0,0 +1,58 @@
+
+////////////////////////////////////////////////////////////////////////////
+//
+// Thread placement.  Each thread has a role, and a role can be given a set
+// of CPUs to run on.  A thread calls 'enter' at the top of its body, which
+// names it, so that it shows up in top -H, perf and gdb, and binds it to
+// the CPUs for its role.
+//
+// Roles are:
+//   capture    Packet capture and delay lines, VXLAN and pcap input.
+//   delivery   Endpoint senders.
+//   receiver   ETSI LI and NHIS 1.1 stream receivers.
+//   analysis   Lua event handling, event output and packet injection.
+//   reaper     Context expiry.
+//   control    Management, metrics and snort alert services.
+//
+// Linux allocates pages on the node of the CPU which first touches them,
+// so buffers which a thread allocates after 'enter' are local to the CPUs
+// it runs on.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_UTIL_THREADS_H
+#define CYBERPROBE_UTIL_THREADS_H
+
+#include <string>
+#include <map>
+#include <set>
+
+namespace cyberprobe {
+
+namespace util {
+
+namespace threads {
+
+    // Parses a CPU list e.g. 0-3,8.  Throws on a bad list.
+    std::set<int> parse_cpus(const std::string& cpus);
+
+    // Sets the CPUs for a role.  An empty list removes the setting.
+    // Throws if the role or list isn't valid.  Affects threads which
+    // start afterwards.
+    void set_cpus(const std::string& role, const std::string& cpus);
+
+    // Replaces all settings, role to CPU list.
+    void configure(const std::map<std::string, std::string>& roles);
+
+    // Names the calling thread, and binds it to the CPUs for its role if
+    // any are set.  Names longer than 15 characters are cut short.
+    void enter(const std::string& role, const std::string& name);
+
+}
+
+}
+
+}
+
+#endif
+
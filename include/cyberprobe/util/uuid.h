@@ -1,43 +1,96 @@
-#include <vector>
-#include <iostream>
-#include <sstream>
-#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////
+//
+// UUIDs for event identifiers.  These are version 7 UUIDs (RFC 9562): a
+// 48-bit millisecond timestamp followed by random bits, so IDs sort
+// roughly by creation time.  The random bits come from a per-thread
+// splitmix64 sequence, so generation needs no locking and no heap.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef CYBERPROBE_UTIL_UUID_H
+#define CYBERPROBE_UTIL_UUID_H
+
+#include <stdint.h>
+#include <time.h>
+
 #include <random>
-#include <algorithm>
-#include <iomanip>
 #include <string>
 
 class uuid {
 public:
-    std::vector<unsigned char> raw;
-    std::string to_string() {
-	assert(raw.size() == 16);
-	std::ostringstream buf;
-	buf << std::hex;
+    unsigned char raw[16];
+
+    // Length of the string form.
+    static const unsigned int string_length = 36;
+
+    // Writes the 8-4-4-4-12 hex form to out, which must have room for
+    // string_length characters.  Not terminated.
+    void format(char* out) const {
+	static const char hex[] = "0123456789abcdef";
 	for(int i = 0; i < 16; i++) {
-	    buf << std::setfill('0') << std::setw(2) << (int) raw[i];
+	    *out++ = hex[raw[i] >> 4];
+	    *out++ = hex[raw[i] & 0xf];
 	    if (i == 3 || i == 5 || i == 7 || i == 9)
-		buf << '-';
+		*out++ = '-';
 	}
+    }
 
-	return buf.str();
+    std::string to_string() const {
+	char buf[string_length];
+	format(buf);
+	return std::string(buf, string_length);
     }
 };
 
 class uuid_generator {
-    std::random_device device;
-    std::mt19937 rand;
-    std::uniform_int_distribution<> dist;
+private:
+
+    // Per-thread generator state.
+    struct state {
+	uint64_t s;
+	state() {
+	    std::random_device device;
+	    s = (uint64_t(device()) << 32) ^ device();
+	}
+	// splitmix64, a counter run through a bijective mixer.
+	uint64_t next() {
+	    uint64_t z = (s += 0x9e3779b97f4a7c15ULL);
+	    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	    return z ^ (z >> 31);
+	}
+    };
+
 public:
-    uuid_generator() : rand(device()), dist(0, 255) {}
-    unsigned char get() {
-	return static_cast<unsigned char>(dist(rand));
-    }
+
+    // Thread-safe, each thread has its own state.
     uuid generate() {
+
+	thread_local state st;
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	uint64_t ms = uint64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+
+	uint64_t a = st.next();
+	uint64_t b = st.next();
+
 	uuid u;
-	for(int i = 0; i < 16; i++)
-	    u.raw.push_back(get());
+	for(int i = 0; i < 6; i++)
+	    u.raw[i] = ms >> (40 - 8 * i);
+	for(int i = 0; i < 8; i++)
+	    u.raw[6 + i] = a >> (56 - 8 * i);
+	u.raw[14] = b >> 56;
+	u.raw[15] = b >> 48;
+
+	// Version 7, RFC 4122 variant.
+	u.raw[6] = (u.raw[6] & 0x0f) | 0x70;
+	u.raw[8] = (u.raw[8] & 0x3f) | 0x80;
+
 	return u;
+
     }
 };
 
+#endif